@@ -0,0 +1,15 @@
+#pragma once
+
+//NVM geometry of the targets, also used by C++ tests which cannot include type.h
+#ifdef LFTL_STM32U5
+#define LFTL_PAGE_SIZE (8*1024)
+#define LFTL_WU_SIZE 16
+#endif
+#ifdef LFTL_STM32L5
+#define LFTL_PAGE_SIZE (2*1024)
+#define LFTL_WU_SIZE 8
+#endif
+#ifdef LFTL_CH32V307
+#define LFTL_PAGE_SIZE (4*1024)
+#define LFTL_WU_SIZE 2
+#endif
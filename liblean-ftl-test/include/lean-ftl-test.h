@@ -6,14 +6,80 @@ uint8_t nvm_erase(void*base_address, unsigned int n_pages);
 uint8_t nvm_write(void*dst_nvm_addr, const void*const src, uintptr_t size);
 uint8_t nvm_read(void* dst, const void*const src_nvm_addr, uintptr_t size);
 void throw_exception(uint32_t err_code);
+#ifdef HAS_NVM_COPY
+uint8_t nvm_copy(void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size);
+uint8_t nvm_start_copy(void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size);
+  #define NVMA_COPY nvm_copy
+  #define NVMA_START_COPY nvm_start_copy
+#else
+  #define NVMA_COPY 0
+  #define NVMA_START_COPY 0
+#endif
+#ifdef HAS_ASYNC_NVM
+uint8_t nvm_start_erase(void*base_address, unsigned int n_pages);
+uint8_t nvm_start_write(void*dst_nvm_addr, const void*const src, uintptr_t size);
+uint8_t nvm_poll_busy();
+
+lftl_async_t nvma_async = {
+  .start_erase = nvm_start_erase,
+  .start_write = nvm_start_write,
+  .poll_busy = nvm_poll_busy,
+  .start_copy = NVMA_START_COPY,
+};
+
+lftl_async_t nvmb_async = {
+  .start_erase = nvm_start_erase,
+  .start_write = nvm_start_write,
+  .poll_busy = nvm_poll_busy,
+};
+  #define NVMA_ASYNC &nvma_async
+  #define NVMB_ASYNC &nvmb_async
+#else
+  #define NVMA_ASYNC 0
+  #define NVMB_ASYNC 0
+#endif
+
+#ifdef LFTL_TRACE
+uint32_t nvm_clock();
+void trace_hook(lftl_ctx_t*ctx, const lftl_trace_event_t*event);
+void timing_hook(lftl_ctx_t*ctx, const lftl_trace_event_t*event);
+
+//installed on nvma by trace_test
+lftl_trace_t nvma_trace = {
+  .hook = trace_hook,
+  .clock = nvm_clock,
+};
+
+//installed on nvma by timing_bench
+lftl_trace_t nvma_timing_trace = {
+  .hook = timing_hook,
+  .clock = nvm_clock,
+};
+#endif
 
 lftl_nvm_props_t nvm_props = {
     .base = &nvm,
     .size = sizeof(nvm),
     .write_size = LFTL_WU_SIZE,
     .erase_size = LFTL_PAGE_SIZE,
+    .skip_erased = 0,
+    .erased_value = 0xFF,
+    .memory_mapped = 1,
   };
 
+//nvmb copies through a small bounce buffer to exercise chunked copies
+uint64_t nvmb_copy_buffer[SIZE64(5*LFTL_WU_SIZE)];
+
+extern lftl_group_t nvm_group;
+
+lftl_stats_t nvma_stats;
+
+uint32_t nvma_wu_writes[sizeof(nvm.a_data)/LFTL_WU_SIZE];
+lftl_profile_t nvma_profile = {
+  .wu_writes = nvma_wu_writes,
+  .n_wu = sizeof(nvma_wu_writes)/sizeof(nvma_wu_writes[0]),
+};
+
 lftl_ctx_t nvma = {
   .nvm_props = &nvm_props,
   .area = &nvm.a_pages,
@@ -25,7 +91,12 @@ lftl_ctx_t nvma = {
   .read = nvm_read,
   .error_handler = throw_exception,
   .transaction_tracker = LFTL_INVALID_POINTER,
-  .next = LFTL_INVALID_POINTER
+  .next = LFTL_INVALID_POINTER,
+  .async = NVMA_ASYNC,
+  .copy = NVMA_COPY,
+  .group = &nvm_group,
+  .stats = &nvma_stats,
+  .profile = &nvma_profile
 };
 
 lftl_ctx_t nvmb = {
@@ -39,8 +110,93 @@ lftl_ctx_t nvmb = {
   .read = nvm_read,
   .error_handler = throw_exception,
   .transaction_tracker = LFTL_INVALID_POINTER,
-  .next = LFTL_INVALID_POINTER
+  .next = LFTL_INVALID_POINTER,
+  .async = NVMB_ASYNC,
+  .copy_buffer = nvmb_copy_buffer,
+  .copy_buffer_size = sizeof(nvmb_copy_buffer),
+  .group = &nvm_group
+};
+
+//const configuration of the pages of nvma, used by area_cfg_test
+const lftl_area_cfg_t nvma_cfg = {
+  .nvm_props = &nvm_props,
+  .area = &nvm.a_pages,
+  .area_size = sizeof(nvm.a_pages),
+  .data_size = sizeof(nvm.a_data),
+  .erase = nvm_erase,
+  .write = nvm_write,
+  .read = nvm_read,
+  .error_handler = throw_exception,
 };
 
+//record of the group made of nvma and nvmb
+lftl_ctx_t nvmr = {
+  .nvm_props = &nvm_props,
+  .area = &nvm.r_pages,
+  .area_size = sizeof(nvm.r_pages),
+  .data = LFTL_INVALID_POINTER,
+  .data_size = sizeof(nvm.r_data),
+  .erase = nvm_erase,
+  .write = nvm_write,
+  .read = nvm_read,
+  .error_handler = throw_exception,
+  .transaction_tracker = LFTL_INVALID_POINTER,
+  .next = LFTL_INVALID_POINTER,
+};
+
+//key-value store area, its log is nvm.kv_log
+lftl_stats_t nvmk_stats;
+
+lftl_ctx_t nvmk = {
+  .nvm_props = &nvm_props,
+  .area = &nvm.k_pages,
+  .area_size = sizeof(nvm.k_pages),
+  .data = LFTL_INVALID_POINTER,
+  .data_size = sizeof(nvm.k_data),
+  .erase = nvm_erase,
+  .write = nvm_write,
+  .read = nvm_read,
+  .error_handler = throw_exception,
+  .transaction_tracker = LFTL_INVALID_POINTER,
+  .next = LFTL_INVALID_POINTER,
+  .stats = &nvmk_stats
+};
+
+//pages of the ring log, not registered
+lftl_ctx_t nvml = {
+  .nvm_props = &nvm_props,
+  .area = &nvm.log_pages,
+  .area_size = sizeof(nvm.log_pages),
+  .data = LFTL_INVALID_POINTER,
+  .erase = nvm_erase,
+  .write = nvm_write,
+  .read = nvm_read,
+  .error_handler = throw_exception,
+  .transaction_tracker = LFTL_INVALID_POINTER,
+  .next = LFTL_INVALID_POINTER,
+};
+
+lftl_ctx_t*nvm_group_members[] = {&nvma, &nvmb};
+
+lftl_group_t nvm_group = {
+  .record = &nvmr,
+  .members = nvm_group_members,
+  .n_members = 2,
+};
+
+//pool made of nvma and nvmb, enabled by pool_seq
+lftl_ctx_t*nvm_pool_areas[] = {&nvma, &nvmb};
+
+lftl_pool_t nvm_pool = {
+  .areas = nvm_pool_areas,
+  .n_areas = 2,
+  .slot_size = LFTL_PAGE_SIZE,
+  .migrate_threshold = 2,
+};
+
+//storage of the areas declared in C++, see test.cpp
+void*const nvm_cpp_pages = &nvm.cpp_pages;
+const uintptr_t nvm_cpp_pages_size = sizeof(nvm.cpp_pages);
+
 int test_main();
 void test_callbacks();
\ No newline at end of file
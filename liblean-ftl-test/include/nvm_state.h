@@ -7,6 +7,7 @@
 data_flash_t nvm __attribute__ ((section (".data_flash"))) = {
   .a_pages = {{0}},
   .b_pages = {{0}},
+  .r_pages = {{0}},
 };
 
 
@@ -3,22 +3,12 @@
 #include "util.h"
 
 #define LFTL_DEFINE_HELPERS
-#ifdef LFTL_STM32U5
-#define LFTL_PAGE_SIZE (8*1024)
-#define LFTL_WU_SIZE 16
-#endif
-#ifdef LFTL_STM32L5
-#define LFTL_PAGE_SIZE (2*1024)
-#define LFTL_WU_SIZE 8
-#endif
-#ifdef LFTL_CH32V307
-#define LFTL_PAGE_SIZE (4*1024)
-#define LFTL_WU_SIZE 2
-#endif
+#include "geometry.h"
 
 #include "lean-ftl.h"
 
 #define DATA_SIZE (4*LFTL_WU_SIZE)
+#define KV_DATA_SIZE 512
 
 typedef struct data_flash_struct {
 
@@ -31,6 +21,18 @@ typedef struct data_flash_struct {
     uint64_t data2[SIZE64(DATA_SIZE)];
     uint64_t data3[SIZE64(DATA_SIZE)];
     ,2)
+
+  LFTL_AREA(r,
+    uint32_t group_record[2*2];
+    ,2)
+
+  LFTL_AREA(k,
+    uint64_t kv_data[SIZE64(KV_DATA_SIZE)];
+    ,2)
+  flash_sw_page_t kv_log;
+  flash_sw_page_t log_pages[3];
+  flash_sw_page_t counter_region;
+  flash_sw_page_t cpp_pages[2];
   union {
     flash_sw_page_t unmanaged_page;
     struct {
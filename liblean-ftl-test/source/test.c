@@ -38,6 +38,19 @@ extern data_flash_t nvm;
 extern lftl_nvm_props_t nvm_props;
 extern lftl_ctx_t nvma;
 extern lftl_ctx_t nvmb;
+extern const lftl_area_cfg_t nvma_cfg;
+extern lftl_ctx_t nvmr;
+extern lftl_ctx_t nvmk;
+extern lftl_ctx_t nvml;
+extern lftl_group_t nvm_group;
+extern lftl_pool_t nvm_pool;
+extern lftl_stats_t nvma_stats;
+extern lftl_stats_t nvmk_stats;
+extern lftl_profile_t nvma_profile;
+#ifdef LFTL_TRACE
+extern lftl_trace_t nvma_trace;
+extern lftl_trace_t nvma_timing_trace;
+#endif
 
 const char*version = xstr(GIT_VERSION);
 
@@ -137,51 +150,60 @@ uint8_t tearing_sim_nvm_erase(void*base_address, unsigned int n_pages){
   memset(base_address,0xFF,size);
   return 0;
 }
-void tearing_sim_lftl_erase_all(lftl_ctx_t*ctx){
+void tearing_sim_ref_erase_all(lftl_ctx_t*ctx){
   //update previous state
   nvm_ref_previous_state = nvm_ref;
   //compute new state
   uint8_t*dst = (uint8_t*)&nvm_ref;
   memset(dst,0xFF,ctx->data_size);
+}
+void tearing_sim_lftl_erase_all(lftl_ctx_t*ctx){
+  tearing_sim_ref_erase_all(ctx);
   //call LFTL
   lftl_erase_all(ctx);
 }
-void tearing_sim_lftl_write(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
+void tearing_sim_ref_write(void*dst_nvm_addr, const void*const src, uintptr_t size){
   //update previous state
   nvm_ref_previous_state = nvm_ref;
   //compute new state
   uintptr_t offset = (uintptr_t)dst_nvm_addr - (uintptr_t)&nvm;
   uint8_t*dst = (uint8_t*)&nvm_ref;
   lftl_memread(dst+offset,src,size);
+}
+void tearing_sim_lftl_write(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
+  tearing_sim_ref_write(dst_nvm_addr,src,size);
   //call LFTL
   lftl_write(ctx,dst_nvm_addr,src,size);
 }
-void tearing_sim_lftl_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker){
+void tearing_sim_ref_transaction_start(lftl_ctx_t*ctx){
   //copy nvm to transaction buffer
   uintptr_t offset = (uintptr_t)ctx->area - (uintptr_t)&nvm;
   uint8_t*dst = (uint8_t*)&transaction_buf_ref;
   uint8_t*src = (uint8_t*)&nvm_ref;
   memcpy(dst+offset,src+offset,ctx->area_size);
+}
+void tearing_sim_lftl_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker){
+  tearing_sim_ref_transaction_start(ctx);
   //call LFTL
   lftl_transaction_start(ctx,transaction_tracker);
 }
-void tearing_sim_lftl_transaction_write(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
+void tearing_sim_ref_transaction_write(void*dst_nvm_addr, const void*const src, uintptr_t size){
   //write into transaction buffer
   uintptr_t offset = (uintptr_t)dst_nvm_addr - (uintptr_t)&nvm;
   uint8_t*dst = (uint8_t*)&transaction_buf_ref;
   lftl_memread(dst+offset,src,size);
+}
+void tearing_sim_lftl_transaction_write(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
+  tearing_sim_ref_transaction_write(dst_nvm_addr,src,size);
   //call LFTL
   lftl_transaction_write(ctx,dst_nvm_addr,src,size);
 }
 void tearing_sim_lftl_transaction_write_any(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
-  //write into transaction buffer
-  uintptr_t offset = (uintptr_t)dst_nvm_addr - (uintptr_t)&nvm;
-  uint8_t*dst = (uint8_t*)&transaction_buf_ref;
-  lftl_memread(dst+offset,src,size);
+  tearing_sim_ref_transaction_write(dst_nvm_addr,src,size);
   //call LFTL
   lftl_transaction_write_any(ctx,dst_nvm_addr,src,size);
 }
-void tearing_sim_lftl_transaction_commit(lftl_ctx_t*ctx){
+void tearing_sim_ref_transaction_commit(lftl_ctx_t*ctx){
   //update previous state
   nvm_ref_previous_state = nvm_ref;
   //copy transaction buffer to nvm
@@ -189,9 +211,24 @@ void tearing_sim_lftl_transaction_commit(lftl_ctx_t*ctx){
   uint8_t*src = (uint8_t*)&transaction_buf_ref;
   uint8_t*dst = (uint8_t*)&nvm_ref;
   memcpy(dst+offset,src+offset,ctx->area_size);
+}
+void tearing_sim_lftl_transaction_commit(lftl_ctx_t*ctx){
+  tearing_sim_ref_transaction_commit(ctx);
   //call LFTL
   lftl_transaction_commit(ctx);
 }
+void tearing_sim_ref_group_commit(lftl_group_t*group){
+  //update previous state once: the whole group is updated atomically
+  nvm_ref_previous_state = nvm_ref;
+  for(uint32_t i=0;i<group->n_members;i++){
+    lftl_ctx_t*ctx = group->members[i];
+    if(LFTL_INVALID_POINTER == ctx->transaction_tracker) continue;
+    uintptr_t offset = (uintptr_t)ctx->area - (uintptr_t)&nvm;
+    uint8_t*src = (uint8_t*)&transaction_buf_ref;
+    uint8_t*dst = (uint8_t*)&nvm_ref;
+    memcpy(dst+offset,src+offset,ctx->area_size);
+  }
+}
 void tearing_sim_lftl_transaction_abort(lftl_ctx_t*ctx){
   //call LFTL
   lftl_transaction_abort(ctx);
@@ -210,6 +247,11 @@ void check_nvm(){
   PRINTF("NVM corrupted\n");
   abort();
 }
+void kv_tearing_check();
+void log_tearing_check();
+void fifo_tearing_check();
+void counter_tearing_check();
+void cpp_tearing_check();
 void tearing_sim_check_nvm(){
   //PRINTF("Simulated tearing\n");//too verbose
   //simulate a reboot
@@ -217,7 +259,25 @@ void tearing_sim_check_nvm(){
   nvma.transaction_tracker = LFTL_INVALID_POINTER;
   nvmb.data = LFTL_INVALID_POINTER;
   nvmb.transaction_tracker = LFTL_INVALID_POINTER;
+  nvma.stream = 0;
+  nvmb.stream = 0;
+  nvma.overlay = 0;
+  nvmb.overlay = 0;
+  nvma.next_data = 0;
+  nvmb.next_data = 0;
+  nvma.trace = 0;
+  nvmr.data = LFTL_INVALID_POINTER;
+  nvmr.transaction_tracker = LFTL_INVALID_POINTER;
+  nvmr.stream = 0;
+  nvmk.data = LFTL_INVALID_POINTER;
+  nvmk.stream = 0;
+  nvmk.next_data = 0;
   check_nvm();
+  kv_tearing_check();
+  log_tearing_check();
+  fifo_tearing_check();
+  counter_tearing_check();
+  cpp_tearing_check();
 }
 void tearing_sim_init();
 uint32_t tearing_sim_get_max_target();
@@ -514,6 +574,996 @@ void transaction_abort_test(){
   read_and_check(&nvma,&nvm.a_data,wbuf0,sizeof(nvm.a_data));//read current data
 }
 
+void sparse_test(){
+  DEBUG_PRINTLN("sparse_test");
+  //every other write unit is erased
+  const uint32_t write_size = nvm_props.write_size;
+  uint8_t wbuf[sizeof(nvm.a_data)];
+  stateful_prng_fill(wbuf,sizeof(wbuf));
+  for(unsigned int i=0;i<sizeof(wbuf);i++){
+    if((i / write_size) % 2) wbuf[i] = nvm_props.erased_value;
+  }
+  test_write(&nvma,&nvm.a_data,wbuf,sizeof(wbuf));
+  test_write(&nvma,nvm.data1,wbuf+1,sizeof(nvm.data1)-1);
+  uint8_t nvma_transaction_tracker[LFTL_TRANSACTION_TRACKER_SIZE(&nvma)];
+  transaction_start_func(&nvma,nvma_transaction_tracker);
+  transaction_write_func(&nvma,nvm.data0,wbuf,2*write_size);
+  transaction_commit_func(&nvma);
+  read_and_check(&nvma,nvm.data0,wbuf,2*write_size);
+}
+
+void transaction_overlay_test(){
+  DEBUG_PRINTLN("transaction_overlay_test");
+  const size_t size = sizeof(nvm.a_data);
+  uint8_t expected[size];
+  stateful_prng_fill(expected,size);
+  test_write(&nvma,&nvm.a_data,expected,size);
+  uint8_t nvma_transaction_tracker[LFTL_TRANSACTION_TRACKER_SIZE(&nvma)];
+  uint32_t entries[LFTL_OVERLAY_SIZE(&nvma,4)/sizeof(uint32_t)];
+  lftl_overlay_t overlay = {.entries = entries, .n_entries = 4};
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_start(&nvma);
+  #endif
+  lftl_transaction_start_overlay(&nvma,nvma_transaction_tracker,&overlay);
+  //update a misaligned counter several times, it is merged in the overlay
+  uint8_t*const counter = ((uint8_t*)nvm.data0)+1;
+  for(uint32_t i=0;i<8;i++){
+    transaction_write_any_func(&nvma,counter,&i,sizeof(i));
+    memcpy(expected+1,&i,sizeof(i));
+    read_newer_and_check(&nvma,&nvm.a_data,expected,size);
+  }
+  //write more write units than the overlay can hold, each once
+  uint8_t wbuf[sizeof(nvm.data1)];
+  stateful_prng_fill(wbuf,sizeof(wbuf));
+  const uint32_t write_size = nvm_props.write_size;
+  for(uint32_t i=0;i<sizeof(wbuf);i+=write_size){
+    transaction_write_func(&nvma,((uint8_t*)nvm.data1)+i,wbuf+i,write_size);
+  }
+  memcpy(expected+sizeof(nvm.data0),wbuf,sizeof(wbuf));
+  read_newer_and_check(&nvma,&nvm.a_data,expected,size);
+  transaction_commit_func(&nvma);
+  read_and_check(&nvma,&nvm.a_data,expected,size);
+}
+
+void transaction_compact_test(){
+  DEBUG_PRINTLN("transaction_compact_test");
+  const size_t size = sizeof(nvm.a_data);
+  uint8_t expected[size];
+  stateful_prng_fill(expected,size);
+  test_write(&nvma,&nvm.a_data,expected,size);
+  uint32_t nvma_transaction_tracker[LFTL_COMPACT_TRACKER_SIZE(3)/sizeof(uint32_t)];
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_start(&nvma);
+  #endif
+  lftl_transaction_start_compact(&nvma,nvma_transaction_tracker,sizeof(nvma_transaction_tracker));
+  const uint32_t write_size = nvm_props.write_size;
+  uint8_t wbuf[size];
+  stateful_prng_fill(wbuf,size);
+  //write units in a shuffled order so ranges are inserted then merged
+  const unsigned int order[] = {6,2,4,3,5,0};
+  for(unsigned int i=0;i<sizeof(order)/sizeof(order[0]);i++){
+    const uintptr_t offset = order[i]*write_size;
+    if(offset >= size) continue;//large write units
+    transaction_write_func(&nvma,((uint8_t*)&nvm.a_data)+offset,wbuf+offset,write_size);
+    memcpy(expected+offset,wbuf+offset,write_size);
+    read_newer_and_check(&nvma,&nvm.a_data,expected,size);
+  }
+  transaction_commit_func(&nvma);
+  read_and_check(&nvma,&nvm.a_data,expected,size);
+}
+
+void group_test(){
+  DEBUG_PRINTLN("group_test");
+  uint8_t nvma_transaction_tracker[LFTL_TRANSACTION_TRACKER_SIZE(&nvma)];
+  uint8_t nvmb_transaction_tracker[LFTL_TRANSACTION_TRACKER_SIZE(&nvmb)];
+  void*const trackers[] = {nvma_transaction_tracker, nvmb_transaction_tracker};
+  uint8_t wbufa[sizeof(nvm.a_data)];
+  uint8_t wbufb[sizeof(nvm.b_data)];
+  for(unsigned int i=0;i<2;i++){
+    stateful_prng_fill(wbufa,sizeof(wbufa));
+    stateful_prng_fill(wbufb,sizeof(wbufb));
+    #ifdef HAS_TEARING_SIMULATION
+    tearing_sim_ref_transaction_start(&nvma);
+    tearing_sim_ref_transaction_start(&nvmb);
+    #endif
+    lftl_group_transaction_start(&nvm_group,trackers);
+    transaction_write_func(&nvma,&nvm.a_data,wbufa,sizeof(wbufa));
+    transaction_write_func(&nvmb,nvm.data2,wbufb,sizeof(nvm.data2));
+    #ifdef HAS_TEARING_SIMULATION
+    tearing_sim_ref_group_commit(&nvm_group);
+    #endif
+    lftl_group_transaction_commit(&nvm_group);
+    read_and_check(&nvma,&nvm.a_data,wbufa,sizeof(wbufa));
+    read_and_check(&nvmb,nvm.data2,wbufb,sizeof(nvm.data2));
+    //mix with regular updates
+    randomized_test_write(&nvmb,nvm.data3,sizeof(nvm.data3));
+  }
+  //a member without transaction keeps its version
+  stateful_prng_fill(wbufa,sizeof(wbufa));
+  transaction_start_func(&nvma,nvma_transaction_tracker);
+  transaction_write_func(&nvma,&nvm.a_data,wbufa,sizeof(wbufa));
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_group_commit(&nvm_group);
+  #endif
+  lftl_group_transaction_commit(&nvm_group);
+  //force a search of the slots
+  nvma.data = LFTL_INVALID_POINTER;
+  nvmb.data = LFTL_INVALID_POINTER;
+  read_and_check(&nvma,&nvm.a_data,wbufa,sizeof(wbufa));
+  read_and_check(&nvmb,nvm.data2,wbufb,sizeof(nvm.data2));
+}
+
+void pool_wear_test(){
+  DEBUG_PRINTLN("pool_wear_test");
+  uint8_t cold[sizeof(nvm.b_data)];
+  lftl_read(&nvmb,cold,&nvm.b_data,sizeof(cold));
+  //nvma is hot, nvmb is cold: nvmb is moved to worn slots from time to time
+  for(unsigned int i=0;i<20;i++){
+    randomized_test_write(&nvma,nvm.data0,sizeof(nvm.data0));
+  }
+  uint32_t min,max;
+  lftl_pool_erase_counts(&nvm_pool,&min,&max);
+  if(max - min > nvm_pool.migrate_threshold + 2) throw_exception(ERROR_VERIFICATION_FAIL);
+  nvmb.data = LFTL_INVALID_POINTER;
+  read_and_check(&nvmb,&nvm.b_data,cold,sizeof(cold));
+}
+
+void get_ctx_test(){
+  DEBUG_PRINTLN("get_ctx_test");
+  lftl_ctx_t*areas[] = {&nvma, &nvmb, &nvmr};
+  for(unsigned int i=0;i<sizeof(areas)/sizeof(areas[0]);i++){
+    lftl_ctx_t*ctx = areas[i];
+    const uint8_t*base = (const uint8_t*)ctx->area;
+    if(ctx != lftl_get_ctx(base)) throw_exception(ERROR_VERIFICATION_FAIL);
+    if(ctx != lftl_get_ctx(base+ctx->data_size-1)) throw_exception(ERROR_VERIFICATION_FAIL);
+    if(ctx != lftl_get_ctx(base+ctx->data_size/2)) throw_exception(ERROR_VERIFICATION_FAIL);
+  }
+  if(LFTL_INVALID_POINTER != lftl_get_ctx(nvm.unmanaged_data0)) throw_exception(ERROR_VERIFICATION_FAIL);
+  uint32_t ram_data;
+  if(LFTL_INVALID_POINTER != lftl_get_ctx(&ram_data)) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+
+void registry_test(){
+  DEBUG_PRINTLN("registry_test");
+  static lftl_registry_t reg;
+  uint8_t expected[sizeof(nvm.data0)];
+  uint8_t actual[sizeof(nvm.data0)];
+  lftl_read(&nvma,expected,nvm.data0,sizeof(nvm.data0));
+  lftl_registry_init(&reg);
+  lftl_registry_register_area(&reg,&nvma);
+  if(&nvma != lftl_registry_get_ctx(&reg,nvm.data0)) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(LFTL_INVALID_POINTER != lftl_registry_get_ctx(&reg,nvmb.area)) throw_exception(ERROR_VERIFICATION_FAIL);
+  lftl_registry_memread(&reg,actual,nvm.data0,sizeof(nvm.data0));
+  if(memcmp(expected,actual,sizeof(actual))) throw_exception(ERROR_VERIFICATION_FAIL);
+  //restore the default registry
+  lftl_init_lib();
+  lftl_register_area(&nvma);
+  lftl_register_area(&nvmb);
+  lftl_register_area(&nvmr);
+  lftl_register_area(&nvmk);
+  if(&nvma != lftl_get_ctx(nvm.data0)) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+
+//like randomized_test_write, the state of an lftl_area_t is not at the offsets of lftl_ctx_t
+void randomized_area_test_write(lftl_area_t*area,void*dst_nvm_addr, uintptr_t size){
+  lftl_ctx_t*ctx = LFTL_AREA_CTX(area);
+  uint8_t wbuf[size];
+  stateful_prng_fill(wbuf,size);
+  write_func(ctx,dst_nvm_addr,wbuf,size);
+  read_and_check(ctx,dst_nvm_addr,wbuf,size);
+  //force a search of the slot
+  area->data = LFTL_INVALID_POINTER;
+  read_and_check(ctx,dst_nvm_addr,wbuf,size);
+}
+
+void area_cfg_test(){
+  DEBUG_PRINTLN("area_cfg_test");
+  lftl_area_ops_t ops = LFTL_AREA_OPS_INIT;
+  lftl_area_t area = LFTL_AREA_INIT(&nvma_cfg,&ops);
+  lftl_ctx_t*ctx = LFTL_AREA_CTX(&area);
+  randomized_area_test_write(&area,nvm.data0,sizeof(nvm.data0));
+  randomized_area_test_write(&area,&nvm.a_data,sizeof(nvm.a_data));
+  //nvma uses the same pages, it sees the new data once mounted again
+  nvma.data = LFTL_INVALID_POINTER;
+  uint8_t expected[sizeof(nvm.a_data)];
+  uint8_t actual[sizeof(nvm.a_data)];
+  lftl_read(ctx,expected,&nvm.a_data,sizeof(expected));
+  lftl_read(&nvma,actual,&nvm.a_data,sizeof(actual));
+  if(memcmp(expected,actual,sizeof(actual))) throw_exception(ERROR_VERIFICATION_FAIL);
+  //transactions size their buffers from the configuration, nvma sees the same pages
+  uint8_t tracker[LFTL_TRANSACTION_TRACKER_SIZE_CFG(&nvma_cfg)];
+  uint8_t wbuf[sizeof(nvm.data0)];
+  stateful_prng_fill(wbuf,sizeof(wbuf));
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_start(&nvma);
+  #endif
+  lftl_transaction_start(ctx,tracker);
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_write(nvm.data0,wbuf,sizeof(wbuf));
+  #endif
+  lftl_transaction_write(ctx,nvm.data0,wbuf,sizeof(wbuf));
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_commit(&nvma);
+  #endif
+  lftl_transaction_commit(ctx);
+  read_and_check(ctx,nvm.data0,wbuf,sizeof(wbuf));
+  //overlay smaller than the data, some write units are evicted
+  uint32_t entries[LFTL_OVERLAY_SIZE_CFG(&nvma_cfg,4)/sizeof(uint32_t)];
+  lftl_overlay_t overlay = {.entries = entries, .n_entries = 4};
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_start(&nvma);
+  #endif
+  lftl_transaction_start_overlay(ctx,tracker,&overlay);
+  uint8_t*const counter = ((uint8_t*)nvm.data0)+1;
+  for(uint32_t i=0;i<4;i++){
+    #ifdef HAS_TEARING_SIMULATION
+    tearing_sim_ref_transaction_write(counter,&i,sizeof(i));
+    #endif
+    lftl_transaction_write_any(ctx,counter,&i,sizeof(i));
+    memcpy(wbuf+1,&i,sizeof(i));
+    read_newer_and_check(ctx,nvm.data0,wbuf,sizeof(wbuf));
+  }
+  stateful_prng_fill(expected,sizeof(nvm.data1));
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_write(nvm.data1,expected,sizeof(nvm.data1));
+  #endif
+  lftl_transaction_write(ctx,nvm.data1,expected,sizeof(nvm.data1));
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_commit(&nvma);
+  #endif
+  lftl_transaction_commit(ctx);
+  read_and_check(ctx,nvm.data0,wbuf,sizeof(wbuf));
+  read_and_check(ctx,nvm.data1,expected,sizeof(nvm.data1));
+  //an area without ops does plain writes
+  lftl_area_t plain = LFTL_AREA_INIT(&nvma_cfg,0);
+  randomized_area_test_write(&plain,nvm.data1,sizeof(nvm.data1));
+  nvma.data = LFTL_INVALID_POINTER;
+}
+
+void get_ptr_test(){
+  DEBUG_PRINTLN("get_ptr_test");
+  randomized_test_write(&nvma,nvm.data0,sizeof(nvm.data0));
+  uint8_t expected[sizeof(nvm.data0)];
+  lftl_read(&nvma,expected,nvm.data0,sizeof(expected));
+  uint32_t generation;
+  const void*ptr = lftl_get_ptr(&nvma,nvm.data0,sizeof(nvm.data0),&generation);
+  if(memcmp(expected,ptr,sizeof(expected))) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(generation != lftl_generation(&nvma)) throw_exception(ERROR_VERIFICATION_FAIL);
+  randomized_test_write(&nvma,nvm.data0,sizeof(nvm.data0));
+  if(generation == lftl_generation(&nvma)) throw_exception(ERROR_VERIFICATION_FAIL);
+  lftl_read(&nvma,expected,nvm.data0,sizeof(expected));
+  ptr = lftl_get_ptr(&nvma,nvm.data0,sizeof(nvm.data0),0);
+  if(memcmp(expected,ptr,sizeof(expected))) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+
+#define KV_N_KEYS 8
+#define KV_MAX_VALUE_SIZE 48
+static lftl_kv_entry_t kv_index[16];
+static lftl_kv_t kv = {
+  .ctx = &nvmk,
+  .log = &nvm.kv_log,
+  .log_size = sizeof(nvm.kv_log),
+  .index = kv_index,
+  .index_size = sizeof(kv_index)/sizeof(kv_index[0]),
+};
+
+//expected content of the store
+typedef struct {
+  uint16_t size[KV_N_KEYS];
+  uint8_t value[KV_N_KEYS][KV_MAX_VALUE_SIZE];
+} kv_model_t;
+static kv_model_t kv_model;
+static kv_model_t kv_model_previous;
+static bool kv_model_active = false;
+
+static bool kv_matches(const kv_model_t*model){
+  for(uint16_t key=0;key<KV_N_KEYS;key++){
+    uint8_t value[KV_MAX_VALUE_SIZE];
+    const uint16_t size = lftl_kv_get(&kv,key,value,sizeof(value));
+    if(size != model->size[key]) return false;
+    if((LFTL_KV_NOT_FOUND != size) && memcmp(value,model->value[key],size)) return false;
+  }
+  return true;
+}
+
+static void kv_random_update(){
+  kv_model_previous = kv_model;
+  const uint16_t key = xs_prng_get() % KV_N_KEYS;
+  const uint32_t r = xs_prng_get();
+  if(0 == (r % 8)){
+    kv_model.size[key] = LFTL_KV_NOT_FOUND;
+    lftl_kv_delete(&kv,key);
+  } else {
+    const uint16_t size = r % (KV_MAX_VALUE_SIZE+1);
+    xs_prng_fill(kv_model.value[key],size);
+    kv_model.size[key] = size;
+    lftl_kv_set(&kv,key,kv_model.value[key],size);
+  }
+}
+
+void kv_test(){
+  DEBUG_PRINTLN("kv_test");
+  kv_model_active = false;
+  lftl_format(&nvmk);
+  lftl_kv_mount(&kv);
+  for(uint16_t key=0;key<KV_N_KEYS;key++) kv_model.size[key] = LFTL_KV_NOT_FOUND;
+  kv_model_previous = kv_model;
+  kv_model_active = true;
+  xs_prng_set_seed(0x4B56);
+  //fill the log several times to trigger compactions
+  const unsigned int n_updates = 3*sizeof(nvm.kv_log)/(KV_MAX_VALUE_SIZE/2+8);
+  for(unsigned int i=0;i<n_updates;i++){
+    kv_random_update();
+    if((0 == (i%16)) && !kv_matches(&kv_model)) throw_exception(ERROR_VERIFICATION_FAIL);
+  }
+  if(!kv_matches(&kv_model)) throw_exception(ERROR_VERIFICATION_FAIL);
+  //simulate a reboot
+  nvmk.data = LFTL_INVALID_POINTER;
+  lftl_kv_mount(&kv);
+  if(!kv_matches(&kv_model)) throw_exception(ERROR_VERIFICATION_FAIL);
+  kv_model_active = false;
+}
+
+#ifdef HAS_TEARING_SIMULATION
+//after a simulated tearing, the store holds the content before or after the interrupted update
+void kv_tearing_check(){
+  if(!kv_model_active) return;
+  kv_model_active = false;
+  lftl_kv_mount(&kv);
+  if(!kv_matches(&kv_model)){
+    if(!kv_matches(&kv_model_previous)){
+      PRINTF("KV store corrupted\n");
+      abort();
+    }
+    kv_model = kv_model_previous;
+  }
+  //the next update discards a torn record
+  const uint8_t value[] = "recovery";
+  memcpy(kv_model.value[0],value,sizeof(value));
+  kv_model.size[0] = sizeof(value);
+  lftl_kv_set(&kv,0,value,sizeof(value));
+  if(!kv_matches(&kv_model)){
+    PRINTF("KV store not recovered\n");
+    abort();
+  }
+}
+#endif
+
+#define LOG_MAX_RECORD_SIZE 32
+static lftl_log_t ring_log = {
+  .ctx = &nvml,
+  .overwrite = 1,
+};
+
+//records first to last-1 are expected in the log, older ones may have been dropped
+typedef struct {
+  uint32_t first;
+  uint32_t last;
+} log_model_t;
+static log_model_t log_model;
+static log_model_t log_model_previous;
+static bool log_model_active = false;
+
+static uint16_t log_record(uint32_t index, uint8_t*buf){
+  const uint16_t size = sizeof(index) + index % (LOG_MAX_RECORD_SIZE - sizeof(index) + 1);
+  memcpy(buf,&index,sizeof(index));
+  for(uint16_t i=sizeof(index);i<size;i++) buf[i] = index*7 + i;
+  return size;
+}
+
+static struct {
+  uint32_t first;
+  uint32_t next;
+  uint32_t n;
+  bool error;
+} log_scan;
+
+static uint8_t log_visitor(void*user, const void*record, uint16_t size){
+  uint8_t expected[LOG_MAX_RECORD_SIZE];
+  uint32_t index;
+  memcpy(&index,record,sizeof(index));
+  if(0 == log_scan.n) log_scan.first = index;
+  else if(index != log_scan.next) log_scan.error = true;
+  if((size != log_record(index,expected)) || memcmp(expected,record,size)) log_scan.error = true;
+  log_scan.next = index + 1;
+  log_scan.n++;
+  return 0;
+}
+
+static bool log_matches(const log_model_t*model){
+  uint8_t buf[LOG_MAX_RECORD_SIZE];
+  log_scan.n = 0;
+  log_scan.error = false;
+  const uint32_t n = lftl_log_iterate(&ring_log,log_visitor,0,buf,sizeof(buf));
+  if(log_scan.error || (n != log_scan.n)) return false;
+  if(model->first == model->last) return 0 == n;
+  return (0 != n) && (log_scan.first >= model->first) && (log_scan.next == model->last);
+}
+
+static void log_append_next(){
+  uint8_t record[LOG_MAX_RECORD_SIZE];
+  const uint16_t size = log_record(log_model.last,record);
+  log_model.last++;
+  lftl_log_append(&ring_log,record,size);
+}
+
+void log_test(){
+  DEBUG_PRINTLN("log_test");
+  log_model_active = false;
+  lftl_log_format(&ring_log);
+  lftl_log_mount(&ring_log);
+  log_model.first = 0;
+  log_model.last = 0;
+  log_model_previous = log_model;
+  log_model_active = true;
+  //wrap the ring more than once
+  const unsigned int n_appends = sizeof(nvm.log_pages)/16;
+  for(unsigned int i=1;i<=n_appends;i++){
+    log_model_previous = log_model;
+    if(0 == (i%128)){
+      if(!log_matches(&log_model)) throw_exception(ERROR_VERIFICATION_FAIL);
+      log_model.first = log_scan.first + 20;
+      log_model_previous.first = log_scan.first;
+      lftl_log_trim(&ring_log,20);
+    } else {
+      log_append_next();
+    }
+  }
+  if(!log_matches(&log_model)) throw_exception(ERROR_VERIFICATION_FAIL);
+  //only the oldest page may have been dropped
+  if(log_scan.n * (LOG_MAX_RECORD_SIZE + 8) < sizeof(nvm.log_pages) - 2*LFTL_PAGE_SIZE) throw_exception(ERROR_VERIFICATION_FAIL);
+  //simulate a reboot
+  lftl_log_mount(&ring_log);
+  if(!log_matches(&log_model)) throw_exception(ERROR_VERIFICATION_FAIL);
+  log_model_previous = log_model;
+  log_model.first = log_model.last;
+  lftl_log_trim(&ring_log,0xFFFFFFFF);
+  if(!log_matches(&log_model)) throw_exception(ERROR_VERIFICATION_FAIL);
+  log_model_active = false;
+}
+
+#ifdef HAS_TEARING_SIMULATION
+//after a simulated tearing, the log holds the records before or after the interrupted call
+void log_tearing_check(){
+  if(!log_model_active) return;
+  log_model_active = false;
+  lftl_log_mount(&ring_log);
+  if(!log_matches(&log_model)){
+    if(!log_matches(&log_model_previous)){
+      PRINTF("ring log corrupted\n");
+      abort();
+    }
+    log_model = log_model_previous;
+  }
+  //the next record goes after a torn one
+  log_append_next();
+  if(!log_matches(&log_model)){
+    PRINTF("ring log not recovered\n");
+    abort();
+  }
+}
+#endif
+
+//the FIFO uses the pages of the ring log
+static lftl_fifo_t fifo = {
+  .log = {.ctx = &nvml},
+};
+#define FIFO_MAX_ENTRIES 64
+
+//entries first to last-1 are expected in the FIFO
+static log_model_t fifo_model;
+static log_model_t fifo_model_previous;
+static bool fifo_model_active = false;
+
+static bool fifo_dequeue_next(){
+  uint8_t entry[LOG_MAX_RECORD_SIZE];
+  uint8_t expected[LOG_MAX_RECORD_SIZE];
+  const uint16_t expected_size = log_record(fifo_model.first,expected);
+  fifo_model.first++;
+  const uint16_t size = lftl_fifo_dequeue(&fifo,entry,sizeof(entry));
+  return (size == expected_size) && (0 == memcmp(entry,expected,size));
+}
+
+void fifo_test(){
+  DEBUG_PRINTLN("fifo_test");
+  uint8_t entry[LOG_MAX_RECORD_SIZE];
+  fifo_model_active = false;
+  lftl_fifo_format(&fifo);
+  lftl_fifo_mount(&fifo);
+  if(LFTL_FIFO_EMPTY != lftl_fifo_dequeue(&fifo,entry,sizeof(entry))) throw_exception(ERROR_VERIFICATION_FAIL);
+  fifo_model.first = 0;
+  fifo_model.last = 0;
+  fifo_model_previous = fifo_model;
+  fifo_model_active = true;
+  xs_prng_set_seed(0x4649);
+  //wrap the ring more than once, at most FIFO_MAX_ENTRIES entries fit in 2 pages
+  const unsigned int n_ops = sizeof(nvm.log_pages)/8;
+  for(unsigned int i=0;i<n_ops;i++){
+    fifo_model_previous = fifo_model;
+    const uint32_t n_entries = fifo_model.last - fifo_model.first;
+    if((0 == n_entries) || ((n_entries < FIFO_MAX_ENTRIES) && (xs_prng_get() % 2))){
+      const uint16_t size = log_record(fifo_model.last,entry);
+      fifo_model.last++;
+      lftl_fifo_enqueue(&fifo,entry,size);
+    } else {
+      if(!fifo_dequeue_next()) throw_exception(ERROR_VERIFICATION_FAIL);
+    }
+  }
+  //simulate a reboot
+  fifo_model_previous = fifo_model;
+  lftl_fifo_mount(&fifo);
+  while(fifo_model.first != fifo_model.last){
+    fifo_model_previous = fifo_model;
+    if(!fifo_dequeue_next()) throw_exception(ERROR_VERIFICATION_FAIL);
+  }
+  if(LFTL_FIFO_EMPTY != lftl_fifo_dequeue(&fifo,entry,sizeof(entry))) throw_exception(ERROR_VERIFICATION_FAIL);
+  lftl_fifo_mount(&fifo);
+  if(LFTL_FIFO_EMPTY != lftl_fifo_dequeue(&fifo,entry,sizeof(entry))) throw_exception(ERROR_VERIFICATION_FAIL);
+  fifo_model_active = false;
+}
+
+#define FIFO_N_PAGES (sizeof(nvm.log_pages)/sizeof(nvm.log_pages[0]))
+
+//bit i is set if page i of the FIFO holds a header
+static uint32_t fifo_pages_in_use(){
+  uint8_t erased[LFTL_WU_SIZE];
+  memset(erased,nvm_props.erased_value,sizeof(erased));
+  uint32_t pages = 0;
+  for(unsigned int i=0;i<FIFO_N_PAGES;i++){
+    if(memcmp(&nvm.log_pages[i],erased,sizeof(erased))) pages |= 1u << i;
+  }
+  return pages;
+}
+
+//offset of the only write unit of a page programmed since the snapshot
+static uintptr_t fifo_programmed_wu(const uint8_t*page, const uint8_t*snapshot){
+  uintptr_t offset = LFTL_PAGE_SIZE;
+  for(uintptr_t i=0;i<LFTL_PAGE_SIZE;i+=LFTL_WU_SIZE){
+    if(0 == memcmp(page+i,snapshot+i,LFTL_WU_SIZE)) continue;
+    if(LFTL_PAGE_SIZE != offset) throw_exception(ERROR_VERIFICATION_FAIL);
+    offset = i;
+  }
+  if(LFTL_PAGE_SIZE == offset) throw_exception(ERROR_VERIFICATION_FAIL);
+  return offset;
+}
+
+//a marker torn by a reset may read as erased during the mount and be partially programmed afterwards
+void fifo_torn_marker_test(){
+  DEBUG_PRINTLN("fifo_torn_marker_test");
+  static uint8_t snapshot[LFTL_PAGE_SIZE];
+  uint8_t entry[LOG_MAX_RECORD_SIZE];
+  fifo_model_active = false;
+  lftl_fifo_format(&fifo);
+  lftl_fifo_mount(&fifo);
+  fifo_model.first = 0;
+  fifo_model.last = 0;
+  fifo_model_previous = fifo_model;
+  fifo_model_active = true;
+  uint8_t torn[LFTL_WU_SIZE];
+  memset(torn,nvm_props.erased_value,sizeof(torn));
+  torn[0] = (uint8_t)~nvm_props.erased_value;
+  //one entry at a time: the first entry of each page is at the same offset
+  uintptr_t entry_marker = LFTL_PAGE_SIZE;
+  uintptr_t page_marker = LFTL_PAGE_SIZE;
+  uint8_t*page = 0;
+  uint32_t pages = fifo_pages_in_use();
+  while(pages != (1u << FIFO_N_PAGES) - 1){
+    fifo_model_previous = fifo_model;
+    const uint16_t size = log_record(fifo_model.last,entry);
+    fifo_model.last++;
+    lftl_fifo_enqueue(&fifo,entry,size);
+    fifo_model_previous = fifo_model;
+    const uint32_t opened = fifo_pages_in_use() & ~pages;
+    pages |= opened;
+    if(0 == opened){
+      if(!fifo_dequeue_next()) throw_exception(ERROR_VERIFICATION_FAIL);
+      continue;
+    }
+    uint8_t*new_page = (uint8_t*)&nvm.log_pages[0];
+    for(uint32_t i=opened;0 == (i & 1);i >>= 1) new_page += LFTL_PAGE_SIZE;
+    uint8_t*torn_marker;
+    if(0 == page){
+      //learn the offset of the marker of the first entry of a page
+      memcpy(snapshot,new_page,LFTL_PAGE_SIZE);
+      if(!fifo_dequeue_next()) throw_exception(ERROR_VERIFICATION_FAIL);
+      entry_marker = fifo_programmed_wu(new_page,snapshot);
+      page = new_page;
+      continue;
+    } else if(LFTL_PAGE_SIZE == page_marker){
+      //tear the marker of the entry, learn the offset of the marker of the page which is now consumed
+      torn_marker = new_page + entry_marker;
+      raw_nvm_write_func(torn_marker,torn,sizeof(torn));
+      memcpy(snapshot,page,LFTL_PAGE_SIZE);
+      if(!fifo_dequeue_next()) throw_exception(ERROR_VERIFICATION_FAIL);
+      page_marker = fifo_programmed_wu(page,snapshot);
+    } else {
+      //tear the marker of the page which is now consumed
+      torn_marker = page + page_marker;
+      raw_nvm_write_func(torn_marker,torn,sizeof(torn));
+      if(!fifo_dequeue_next()) throw_exception(ERROR_VERIFICATION_FAIL);
+    }
+    //the torn marker is left untouched
+    if(memcmp(torn_marker,torn,sizeof(torn))) throw_exception(ERROR_VERIFICATION_FAIL);
+    page = new_page;
+  }
+  //simulate a reboot, both torn markers read as programmed
+  fifo_model_previous = fifo_model;
+  lftl_fifo_mount(&fifo);
+  if(LFTL_FIFO_EMPTY != lftl_fifo_dequeue(&fifo,entry,sizeof(entry))) throw_exception(ERROR_VERIFICATION_FAIL);
+  fifo_model_active = false;
+}
+
+#ifdef HAS_TEARING_SIMULATION
+//after a simulated tearing, the FIFO holds the entries before or after the interrupted call
+void fifo_tearing_check(){
+  if(!fifo_model_active) return;
+  fifo_model_active = false;
+  lftl_fifo_mount(&fifo);
+  uint8_t entry[LOG_MAX_RECORD_SIZE];
+  uint8_t expected[LOG_MAX_RECORD_SIZE];
+  uint16_t size;
+  uint32_t first = 0;
+  uint32_t next = 0;
+  uint32_t n = 0;
+  bool error = false;
+  while(LFTL_FIFO_EMPTY != (size = lftl_fifo_dequeue(&fifo,entry,sizeof(entry)))){
+    uint32_t index;
+    memcpy(&index,entry,sizeof(index));
+    if(0 == n) first = index;
+    else if(index != next) error = true;
+    if((size != log_record(index,expected)) || memcmp(expected,entry,size)) error = true;
+    next = index + 1;
+    n++;
+  }
+  const bool is_current = (n == fifo_model.last - fifo_model.first) && ((0 == n) || (first == fifo_model.first));
+  const bool is_previous = (n == fifo_model_previous.last - fifo_model_previous.first) && ((0 == n) || (first == fifo_model_previous.first));
+  if(error || !(is_current || is_previous)){
+    PRINTF("FIFO corrupted\n");
+    abort();
+  }
+  //the next entry goes after a torn one
+  const uint16_t expected_size = log_record(fifo_model.last,expected);
+  lftl_fifo_enqueue(&fifo,expected,expected_size);
+  size = lftl_fifo_dequeue(&fifo,entry,sizeof(entry));
+  if((size != expected_size) || memcmp(expected,entry,size) || (LFTL_FIFO_EMPTY != lftl_fifo_dequeue(&fifo,entry,sizeof(entry)))){
+    PRINTF("FIFO not recovered\n");
+    abort();
+  }
+}
+#endif
+
+static lftl_counter_t counter = {
+  .ctx = &nvmk,
+  .base = nvm.kv_data,
+  .region = &nvm.counter_region,
+  .region_size = sizeof(nvm.counter_region),
+};
+static uint32_t counter_model;
+static bool counter_model_active = false;
+
+void counter_test(){
+  DEBUG_PRINTLN("counter_test");
+  counter_model_active = false;
+  lftl_format(&nvmk);
+  lftl_counter_mount(&counter);
+  if(0 != lftl_counter_read(&counter)) throw_exception(ERROR_VERIFICATION_FAIL);
+  counter_model = 0;
+  counter_model_active = true;
+  //exhaust the region twice to commit new base values
+  const unsigned int n_increments = 2*sizeof(nvm.counter_region)/LFTL_WU_SIZE;
+  for(unsigned int i=0;i<n_increments;i++){
+    counter_model++;
+    if(counter_model != lftl_counter_increment(&counter)) throw_exception(ERROR_VERIFICATION_FAIL);
+  }
+  //simulate a reboot
+  nvmk.data = LFTL_INVALID_POINTER;
+  lftl_counter_mount(&counter);
+  if(counter_model != lftl_counter_read(&counter)) throw_exception(ERROR_VERIFICATION_FAIL);
+  counter_model_active = false;
+}
+
+//a marker torn by a reset may read as erased during the mount and be partially programmed afterwards
+void counter_torn_marker_test(){
+  DEBUG_PRINTLN("counter_torn_marker_test");
+  counter_model_active = false;
+  lftl_format(&nvmk);
+  lftl_counter_mount(&counter);
+  counter_model = 0;
+  counter_model_active = true;
+  for(unsigned int i=0;i<3;i++){
+    counter_model++;
+    if(counter_model != lftl_counter_increment(&counter)) throw_exception(ERROR_VERIFICATION_FAIL);
+  }
+  //the first erased write unit is the next marker
+  uint8_t*slot = (uint8_t*)&nvm.counter_region;
+  uint8_t erased[LFTL_WU_SIZE];
+  memset(erased,nvm_props.erased_value,sizeof(erased));
+  while(memcmp(slot,erased,sizeof(erased))) slot += LFTL_WU_SIZE;
+  uint8_t torn[LFTL_WU_SIZE];
+  memcpy(torn,erased,sizeof(torn));
+  torn[0] = (uint8_t)~nvm_props.erased_value;
+  //the torn marker counts as soon as it is seen
+  counter_model++;
+  raw_nvm_write_func(slot,torn,sizeof(torn));
+  //it is consumed by the next increment, not programmed again
+  counter_model++;
+  if(counter_model != lftl_counter_increment(&counter)) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(memcmp(slot,torn,sizeof(torn))) throw_exception(ERROR_VERIFICATION_FAIL);
+  counter_model++;
+  if(counter_model != lftl_counter_increment(&counter)) throw_exception(ERROR_VERIFICATION_FAIL);
+  //simulate a reboot
+  nvmk.data = LFTL_INVALID_POINTER;
+  lftl_counter_mount(&counter);
+  if(counter_model != lftl_counter_read(&counter)) throw_exception(ERROR_VERIFICATION_FAIL);
+  counter_model_active = false;
+}
+
+#ifdef HAS_TEARING_SIMULATION
+//after a simulated tearing, the counter holds the value before or after the interrupted increment
+void counter_tearing_check(){
+  if(!counter_model_active) return;
+  counter_model_active = false;
+  lftl_counter_mount(&counter);
+  const uint32_t value = lftl_counter_read(&counter);
+  if((value != counter_model) && (value != counter_model - 1)){
+    PRINTF("counter corrupted\n");
+    abort();
+  }
+  if(value + 1 != lftl_counter_increment(&counter)){
+    PRINTF("counter not recovered\n");
+    abort();
+  }
+}
+#endif
+
+#ifdef LFTL_STATS
+//wear caused by updates of small items: fixed layout in an LFTL area vs key-value store
+void kv_bench(){
+  DEBUG_PRINTLN("kv_bench");
+  const unsigned int n_updates = 256;
+  uint8_t value[16];
+  lftl_stats_t fixed;
+  lftl_stats_t store;
+  lftl_format(&nvmk);
+  memset(&nvmk_stats,0,sizeof(nvmk_stats));
+  xs_prng_set_seed(1);
+  for(unsigned int i=0;i<n_updates;i++){
+    const uint16_t key = xs_prng_get() % KV_N_KEYS;
+    xs_prng_fill(value,sizeof(value));
+    lftl_write(&nvmk,(uint8_t*)nvm.kv_data + key*sizeof(value),value,sizeof(value));
+  }
+  lftl_get_stats(&nvmk,&fixed);
+  lftl_format(&nvmk);
+  lftl_kv_mount(&kv);
+  memset(&nvmk_stats,0,sizeof(nvmk_stats));
+  xs_prng_set_seed(1);
+  for(unsigned int i=0;i<n_updates;i++){
+    const uint16_t key = xs_prng_get() % KV_N_KEYS;
+    xs_prng_fill(value,sizeof(value));
+    lftl_kv_set(&kv,key,value,sizeof(value));
+  }
+  lftl_get_stats(&nvmk,&store);
+  PRINTLN("%u updates of %u bytes:",n_updates,(unsigned int)sizeof(value));
+  PRINTLN("  fixed layout:    %8lu bytes programmed, %5lu pages erased",(unsigned long)fixed.programmed_bytes,(unsigned long)fixed.erased_pages);
+  PRINTLN("  key-value store: %8lu bytes programmed, %5lu pages erased",(unsigned long)store.programmed_bytes,(unsigned long)store.erased_pages);
+  if(store.programmed_bytes >= fixed.programmed_bytes) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(store.erased_pages >= fixed.erased_pages) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+#endif
+
+#ifdef LFTL_STATS
+void stats_test(){
+  DEBUG_PRINTLN("stats_test");
+  memset(&nvma_stats,0,sizeof(nvma_stats));
+  randomized_test_write(&nvma,nvm.data0,sizeof(nvm.data0));
+  lftl_stats_t stats;
+  lftl_get_stats(&nvma,&stats);
+  if(stats.logical_bytes_written != sizeof(nvm.data0)) throw_exception(ERROR_VERIFICATION_FAIL);
+  //the whole data of the slot is programmed, plus meta data
+  if(stats.programmed_bytes <= sizeof(nvm.a_data)) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(stats.write_amplification <= 1000) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(0 == stats.erased_pages) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(stats.crc_bytes < sizeof(nvm.a_data)) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(0 == stats.mounts) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(0 == stats.read_calls) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+#endif
+
+#ifdef LFTL_PROFILE
+void profile_test(){
+  DEBUG_PRINTLN("profile_test");
+  const unsigned int n_data0 = 5;
+  const unsigned int n_data1 = 2;
+  memset(nvma_profile.wu_writes,0,nvma_profile.n_wu*sizeof(uint32_t));
+  nvma_profile.updates = 0;
+  for(unsigned int i=0;i<n_data0;i++){
+    randomized_test_write(&nvma,nvm.data0,sizeof(nvm.data0));
+  }
+  for(unsigned int i=0;i<n_data1;i++){
+    //unaligned write: partially written write units are counted too
+    randomized_test_write(&nvma,(uint8_t*)nvm.data1 + 1,sizeof(nvm.data1) - 2);
+  }
+  if(n_data0 != lftl_profile_writes(&nvma,nvm.data0,sizeof(nvm.data0))) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(n_data1 != lftl_profile_writes(&nvma,nvm.data1,sizeof(nvm.data1))) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(n_data0 != lftl_profile_writes(&nvma,nvm.data0,sizeof(nvm.a_data))) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(n_data0 + n_data1 != nvma_profile.updates) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+
+//print the profile in the format read by tools/lftl-split.py
+void profile_report(){
+  profile_test();
+  PRINTLN("LFTL_PROFILE,a,,%u,%lu",(unsigned int)sizeof(nvm.a_data),(unsigned long)nvma_profile.updates);
+  PRINTLN("LFTL_PROFILE,a,data0,%u,%lu",(unsigned int)sizeof(nvm.data0),(unsigned long)lftl_profile_writes(&nvma,nvm.data0,sizeof(nvm.data0)));
+  PRINTLN("LFTL_PROFILE,a,data1,%u,%lu",(unsigned int)sizeof(nvm.data1),(unsigned long)lftl_profile_writes(&nvma,nvm.data1,sizeof(nvm.data1)));
+}
+#endif
+
+#ifdef LFTL_TRACE
+uint32_t nvm_clock();
+static struct {
+  uint32_t depth;
+  uint32_t n_api;
+  uint32_t n_accessors;
+  bool in_accessor;
+  uint32_t timestamp;
+  bool error;
+} trace_rec;
+
+void trace_hook(lftl_ctx_t*ctx, const lftl_trace_event_t*event){
+  switch(event->type){
+  case LFTL_TRACE_API_ENTER:
+    trace_rec.depth++;
+    trace_rec.n_api++;
+    break;
+  case LFTL_TRACE_API_EXIT:
+    if(0 == trace_rec.depth) trace_rec.error = true;
+    trace_rec.depth--;
+    break;
+  case LFTL_TRACE_ACCESSOR_START:
+    if(trace_rec.in_accessor) trace_rec.error = true;
+    trace_rec.in_accessor = true;
+    trace_rec.n_accessors++;
+    break;
+  case LFTL_TRACE_ACCESSOR_END:
+    if(!trace_rec.in_accessor) trace_rec.error = true;
+    trace_rec.in_accessor = false;
+    break;
+  default:
+    trace_rec.error = true;
+  }
+  //the clock may wrap around
+  if((int32_t)(event->timestamp - trace_rec.timestamp) < 0) trace_rec.error = true;
+  trace_rec.timestamp = event->timestamp;
+}
+
+void trace_test(){
+  DEBUG_PRINTLN("trace_test");
+  memset(&trace_rec,0,sizeof(trace_rec));
+  trace_rec.timestamp = nvm_clock();
+  nvma.trace = &nvma_trace;
+  randomized_test_write(&nvma,nvm.data0,sizeof(nvm.data0));
+  uint8_t nvma_transaction_tracker[LFTL_TRANSACTION_TRACKER_SIZE(&nvma)];
+  transaction_start_func(&nvma,nvma_transaction_tracker);
+  transaction_write_func(&nvma,nvm.data1,nvm.unmanaged_data0,sizeof(nvm.data1));
+  transaction_commit_func(&nvma);
+  nvma.trace = 0;
+  if(trace_rec.error) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(trace_rec.depth || trace_rec.in_accessor) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(trace_rec.n_api < 6) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(trace_rec.n_accessors < trace_rec.n_api) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+#endif
+
+#ifdef LFTL_TRACE
+//time spent in each API function and in the accessors it calls, in nvm_clock ticks
+#define TIMING_MAX_FUNCTIONS 8
+static struct {
+  const char*name[TIMING_MAX_FUNCTIONS];
+  uint32_t calls[TIMING_MAX_FUNCTIONS];
+  uint32_t ticks[TIMING_MAX_FUNCTIONS];
+  uint32_t accessor_ticks[TIMING_MAX_FUNCTIONS];
+  unsigned int n;
+  unsigned int current;
+  uint32_t depth;
+  uint32_t enter;
+  uint32_t accessor_start;
+} timing;
+
+void timing_hook(lftl_ctx_t*ctx, const lftl_trace_event_t*event){
+  switch(event->type){
+  case LFTL_TRACE_API_ENTER:
+    //nested API calls are counted in the outer one
+    if(timing.depth++) break;
+    timing.current = 0;
+    while((timing.current < timing.n) && strcmp(timing.name[timing.current],event->name)) timing.current++;
+    if(TIMING_MAX_FUNCTIONS == timing.current) throw_exception(ERROR_VERIFICATION_FAIL);
+    if(timing.current == timing.n) timing.name[timing.n++] = event->name;
+    timing.calls[timing.current]++;
+    timing.enter = event->timestamp;
+    break;
+  case LFTL_TRACE_API_EXIT:
+    if(0 == --timing.depth) timing.ticks[timing.current] += event->timestamp - timing.enter;
+    break;
+  case LFTL_TRACE_ACCESSOR_START:
+    timing.accessor_start = event->timestamp;
+    break;
+  case LFTL_TRACE_ACCESSOR_END:
+    if(timing.depth) timing.accessor_ticks[timing.current] += event->timestamp - timing.accessor_start;
+    break;
+  }
+}
+
+//cycles per operation on the devices, nanoseconds on linux
+void timing_bench(){
+  DEBUG_PRINTLN("timing_bench");
+  const unsigned int n_iterations = 64;
+  uint8_t wbuf[sizeof(nvm.data0)];
+  uint8_t rbuf[sizeof(nvm.data0)];
+  uint8_t nvma_transaction_tracker[LFTL_TRANSACTION_TRACKER_SIZE(&nvma)];
+  memset(&timing,0,sizeof(timing));
+  nvma.trace = &nvma_timing_trace;
+  for(unsigned int i=0;i<n_iterations;i++){
+    stateful_prng_fill(wbuf,sizeof(wbuf));
+    lftl_write(&nvma,nvm.data0,wbuf,sizeof(wbuf));
+    lftl_read(&nvma,rbuf,nvm.data0,sizeof(rbuf));
+    if(memcmp(wbuf,rbuf,sizeof(rbuf))) throw_exception(ERROR_VERIFICATION_FAIL);
+    lftl_transaction_start(&nvma,nvma_transaction_tracker);
+    lftl_transaction_write(&nvma,nvm.data0,rbuf,sizeof(rbuf));
+    lftl_transaction_write(&nvma,nvm.data1,wbuf,sizeof(wbuf));
+    lftl_transaction_commit(&nvma);
+  }
+  nvma.trace = 0;
+  PRINTLN("%u iterations, nvm_clock ticks per call:",n_iterations);
+  for(unsigned int i=0;i<timing.n;i++){
+    PRINTLN("  %-24s %8lu total, %8lu in accessors",timing.name[i],(unsigned long)(timing.ticks[i]/timing.calls[i]),(unsigned long)(timing.accessor_ticks[i]/timing.calls[i]));
+  }
+}
+#endif
+
+#ifdef HAS_ASYNC_NVM
+static unsigned int async_busy_cnt = 0;
+static void async_wait(lftl_ctx_t*ctx){
+  while(LFTL_ASYNC_BUSY == lftl_async_poll(ctx)){
+    async_busy_cnt++;//the application could do something useful here
+  }
+}
+void async_lftl_write(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_write(dst_nvm_addr,src,size);
+  #endif
+  lftl_async_write(ctx,dst_nvm_addr,src,size);
+  async_wait(ctx);
+}
+void async_lftl_erase_all(lftl_ctx_t*ctx){
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_erase_all(ctx);
+  #endif
+  lftl_async_erase_all(ctx);
+  async_wait(ctx);
+}
+void async_lftl_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker){
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_start(ctx);
+  #endif
+  lftl_async_transaction_start(ctx,transaction_tracker);
+  async_wait(ctx);
+}
+void async_lftl_transaction_write(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_write(dst_nvm_addr,src,size);
+  #endif
+  lftl_async_write(ctx,dst_nvm_addr,src,size);
+  async_wait(ctx);
+}
+void async_lftl_transaction_commit(lftl_ctx_t*ctx){
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_transaction_commit(ctx);
+  #endif
+  lftl_async_transaction_commit(ctx);
+  async_wait(ctx);
+}
+#endif
+
 void write_func_using_transaction(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
   uint8_t transaction_tracker[LFTL_TRANSACTION_TRACKER_SIZE(ctx)];
   transaction_start_func(ctx,transaction_tracker);
@@ -521,8 +1571,24 @@ void write_func_using_transaction(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*c
   transaction_commit_func(ctx);
 }
 
-
-
+void write_func_using_stream(lftl_ctx_t*ctx,void*dst_nvm_addr, const void*const src, uintptr_t size){
+  #ifdef HAS_TEARING_SIMULATION
+  tearing_sim_ref_write(dst_nvm_addr,src,size);
+  #endif
+  lftl_stream_t stream;
+  lftl_stream_begin(ctx,&stream,dst_nvm_addr);
+  //append chunks of increasing sizes
+  const uint8_t*src8 = (const uint8_t*)src;
+  uintptr_t chunk_size = 1;
+  while(size){
+    const uintptr_t n = chunk_size > size ? size : chunk_size;
+    lftl_stream_append(ctx,&stream,src8,n);
+    src8 += n;
+    size -= n;
+    chunk_size = 2*chunk_size + 1;
+  }
+  lftl_stream_commit(ctx,&stream);
+}
 
 void exception_handler(uint32_t err_code){
   #ifdef HAS_TEARING_SIMULATION
@@ -557,8 +1623,11 @@ void test_and_simulate_tearing(void (*dut)()){
     lftl_init_lib();
     lftl_register_area(&nvma);
     lftl_register_area(&nvmb);
+    lftl_register_area(&nvmr);
+    lftl_register_area(&nvmk);
     format_func(&nvma);
     format_func(&nvmb);
+    format_func(&nvmr);
     #ifdef HAS_TEARING_SIMULATION
     tearing_sim_init();
     #endif
@@ -622,12 +1691,211 @@ void transaction_nvm_to_nvm_seq(){
   write_func = org_write_func;
 }
 
+void stream_seq(){
+  DEBUG_PRINTLN("stream_seq");
+  write_func_t org_write_func = write_func;
+  write_func = write_func_using_stream;
+  test_and_simulate_tearing(basic_test);
+  test_and_simulate_tearing(write_size_test);
+  test_and_simulate_tearing(write_offset_test);
+  write_nvm_to_nvm_seq();
+  write_func = org_write_func;
+}
+
+void skip_erased_seq(){
+  DEBUG_PRINTLN("skip_erased_seq");
+  nvm_props.skip_erased = 1;
+  test_and_simulate_tearing(basic_test);
+  test_and_simulate_tearing(sparse_test);
+  test_and_simulate_tearing(transaction_basic_test);
+  test_and_simulate_tearing(erase_all_test);
+  write_nvm_to_nvm_seq();
+  nvm_props.skip_erased = 0;
+}
+
+#ifdef HAS_PTHREAD
+#include <pthread.h>
+#include <time.h>
+static pthread_mutex_t nvma_mutex;
+static void mutex_lock(void*handle){pthread_mutex_lock(handle);}
+static void mutex_unlock(void*handle){pthread_mutex_unlock(handle);}
+
+//installed on nvma by concurrency_stress_test
+static lftl_lock_t nvma_lock = {
+  .lock = mutex_lock,
+  .unlock = mutex_unlock,
+  .handle = &nvma_mutex,
+};
+
+#define STRESS_N_WORDS (sizeof(nvm.data0)/(sizeof(uint32_t)))
+
+static struct {
+  bool done;
+  bool error;
+  uint64_t reads;
+} stress;
+
+//each write fills data0 with a single repeated word, a torn read would mix two of them
+static void*stress_reader(void*arg){
+  (void)arg;
+  uint32_t buf[STRESS_N_WORDS];
+  while(!__atomic_load_n(&stress.done,__ATOMIC_ACQUIRE)){
+    lftl_read(&nvma,buf,nvm.data0,sizeof(buf));
+    for(unsigned int i=1;i<STRESS_N_WORDS;i++){
+      if(buf[i] != buf[0]) stress.error = true;
+    }
+    stress.reads++;
+  }
+  return 0;
+}
+
+static double now_s(){
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+void concurrency_stress_test(){
+  DEBUG_PRINTLN("concurrency_stress_test");
+  const unsigned int n_writes = 20000;
+  uint32_t pattern[STRESS_N_WORDS];
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&nvma_mutex,&attr);
+  pthread_mutexattr_destroy(&attr);
+  nvma.lock = &nvma_lock;
+  memset(pattern,0,sizeof(pattern));
+  lftl_write(&nvma,nvm.data0,pattern,sizeof(pattern));
+  stress.done = false;
+  stress.error = false;
+  stress.reads = 0;
+  pthread_t reader;
+  if(pthread_create(&reader,0,stress_reader,0)) throw_exception(INTERNAL_ERROR_CORRUPT);
+  const double start = now_s();
+  for(unsigned int i=1;i<=n_writes;i++){
+    for(unsigned int j=0;j<STRESS_N_WORDS;j++) pattern[j] = i;
+    lftl_write(&nvma,nvm.data0,pattern,sizeof(pattern));
+  }
+  const double elapsed = now_s() - start;
+  __atomic_store_n(&stress.done,true,__ATOMIC_RELEASE);
+  pthread_join(reader,0);
+  nvma.lock = 0;
+  pthread_mutex_destroy(&nvma_mutex);
+  PRINTF("%u writes, %lu concurrent reads in %.6f s: %.0f reads/s\n",n_writes,(unsigned long)stress.reads,elapsed,stress.reads/elapsed);
+  if(stress.error) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+
+//not under tearing simulation: a simulated tearing would leave the reader thread running
+void concurrency_seq(){
+  DEBUG_PRINTLN("concurrency_seq");
+  uint32_t err_code;
+  if(0 == (err_code = setjmp(exception_ctx))){
+    #ifdef HAS_TEARING_SIMULATION
+    tearing_sim_init();
+    #endif
+    lftl_init_lib();
+    lftl_register_area(&nvma);
+    lftl_register_area(&nvmb);
+    lftl_register_area(&nvmr);
+    lftl_register_area(&nvmk);
+    lftl_format(&nvma);
+    concurrency_stress_test();
+  } else {
+    exception_handler(err_code);
+    exit(err_code);
+  }
+}
+#endif
+
+//run a test once, not under tearing simulation
+void run_once(void (*dut)()){
+  uint32_t err_code;
+  if(0 == (err_code = setjmp(exception_ctx))){
+    #ifdef HAS_TEARING_SIMULATION
+    tearing_sim_init();
+    #endif
+    dut();
+  } else {
+    exception_handler(err_code);
+    #ifdef HAS_TEARING_SIMULATION
+      exit(err_code);
+    #endif
+    ui_wait_button();
+    while(1);
+  }
+}
+
+void kv_seq(){
+  DEBUG_PRINTLN("kv_seq");
+  test_and_simulate_tearing(kv_test);
+  #ifdef LFTL_STATS
+  //not under tearing simulation: the fixed layout erases a page at each update
+  run_once(kv_bench);
+  #endif
+}
+
+#ifdef LFTL_PROFILE
+void profile_seq(){
+  DEBUG_PRINTLN("profile_seq");
+  test_and_simulate_tearing(profile_test);
+  //not under tearing simulation: print the profile once
+  run_once(profile_report);
+}
+#endif
+
+void pool_seq(){
+  DEBUG_PRINTLN("pool_seq");
+  nvma.pool = &nvm_pool;
+  nvmb.pool = &nvm_pool;
+  test_and_simulate_tearing(basic_test);
+  test_and_simulate_tearing(transaction_basic_test);
+  test_and_simulate_tearing(group_test);
+  test_and_simulate_tearing(erase_all_test);
+  test_and_simulate_tearing(pool_wear_test);
+  nvma.pool = 0;
+  nvmb.pool = 0;
+  nvma.next_data = 0;
+  nvmb.next_data = 0;
+}
+
+#ifdef HAS_ASYNC_NVM
+void async_seq(){
+  DEBUG_PRINTLN("async_seq");
+  write_func_t org_write_func = write_func;
+  void (*org_erase_all_func)(lftl_ctx_t*ctx) = erase_all_func;
+  void (*org_transaction_start_func)(lftl_ctx_t*ctx, void *const transaction_tracker) = transaction_start_func;
+  write_func_t org_transaction_write_func = transaction_write_func;
+  write_func_t org_transaction_write_any_func = transaction_write_any_func;
+  void (*org_transaction_commit_func)(lftl_ctx_t*ctx) = transaction_commit_func;
+  write_func = async_lftl_write;
+  erase_all_func = async_lftl_erase_all;
+  transaction_start_func = async_lftl_transaction_start;
+  transaction_write_func = async_lftl_transaction_write;
+  transaction_write_any_func = async_lftl_transaction_write;
+  transaction_commit_func = async_lftl_transaction_commit;
+  test_and_simulate_tearing(basic_test);
+  test_and_simulate_tearing(write_offset_test);
+  test_and_simulate_tearing(transaction_basic_test);
+  test_and_simulate_tearing(erase_all_test);
+  PRINTLN("async: %u polls while busy",async_busy_cnt);
+  write_func = org_write_func;
+  erase_all_func = org_erase_all_func;
+  transaction_start_func = org_transaction_start_func;
+  transaction_write_func = org_transaction_write_func;
+  transaction_write_any_func = org_transaction_write_any_func;
+  transaction_commit_func = org_transaction_commit_func;
+}
+#endif
+
 void print_lib_info(){
   PRINTLN("version: %s",lftl_version());
   PRINTLN("version timestamp: %llu",(long long unsigned int)lftl_version_timestamp());
   PRINTLN("build type: %s",lftl_build_type());
 }
 
+void cpp_seq();//see test.cpp
+
 int test_main(){
   #ifdef HAS_TEARING_SIMULATION
     format_func = tearing_sim_lftl_format;
@@ -660,9 +1928,43 @@ int test_main(){
   test_and_simulate_tearing(write_offset_test);
   test_and_simulate_tearing(transaction_basic_test);
   test_and_simulate_tearing(transaction_abort_test);
+  test_and_simulate_tearing(transaction_overlay_test);
+  test_and_simulate_tearing(transaction_compact_test);
+  test_and_simulate_tearing(group_test);
   test_and_simulate_tearing(erase_all_test);
+  test_and_simulate_tearing(get_ctx_test);
+  test_and_simulate_tearing(registry_test);
+  test_and_simulate_tearing(area_cfg_test);
+  test_and_simulate_tearing(get_ptr_test);
+  test_and_simulate_tearing(log_test);
+  test_and_simulate_tearing(fifo_test);
+  test_and_simulate_tearing(fifo_torn_marker_test);
+  test_and_simulate_tearing(counter_test);
+  test_and_simulate_tearing(counter_torn_marker_test);
+  #ifdef LFTL_STATS
+  test_and_simulate_tearing(stats_test);
+  #endif
+  #ifdef LFTL_TRACE
+  test_and_simulate_tearing(trace_test);
+  //not under tearing simulation: the timings would include the simulation
+  run_once(timing_bench);
+  #endif
   write_nvm_to_nvm_seq();
   transaction_nvm_to_nvm_seq();
+  stream_seq();
+  skip_erased_seq();
+  pool_seq();
+  kv_seq();
+  #ifdef LFTL_PROFILE
+  profile_seq();
+  #endif
+  cpp_seq();
+  #ifdef HAS_ASYNC_NVM
+  async_seq();
+  #endif
+  #ifdef HAS_PTHREAD
+  concurrency_seq();
+  #endif
   #ifdef HAS_PRINTF
     PRINTLN("All tests PASSED");
   #else
@@ -0,0 +1,312 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+#include "util.h"
+#include "geometry.h"
+#include "lean-ftl.hpp"
+
+extern "C" {
+#include "error.h"
+//lean-ftl low level NVM accessors
+uint8_t nvm_erase(void*base_address, unsigned int n_pages);
+uint8_t nvm_write(void*dst_nvm_addr, const void*const src, uintptr_t size);
+uint8_t nvm_read(void* dst, const void*const src_nvm_addr, uintptr_t size);
+void test_and_simulate_tearing(void (*dut)());
+void run_once(void (*dut)());
+#ifdef HAS_ASYNC_NVM
+uint8_t nvm_start_erase(void*base_address, unsigned int n_pages);
+uint8_t nvm_start_write(void*dst_nvm_addr, const void*const src, uintptr_t size);
+uint8_t nvm_poll_busy();
+//latencies of the simulated NVM
+extern uint32_t nvm_erase_busy_us;
+extern uint32_t nvm_write_busy_us;
+#endif
+extern lftl_nvm_props_t nvm_props;
+extern void*const nvm_cpp_pages;
+extern const uintptr_t nvm_cpp_pages_size;
+void cpp_seq();
+void cpp_tearing_check();
+}
+
+using TestNvm = lftl::NvmTraits<&nvm_props, LFTL_PAGE_SIZE, LFTL_WU_SIZE, nvm_erase, nvm_write, nvm_read>;
+
+struct Settings {
+  uint32_t boot_count;
+  uint8_t key[16];
+  uint16_t flags[4];
+  uint32_t pad;
+} __attribute__ ((aligned (LFTL_WU_SIZE)));
+
+using SettingsArea = lftl::Area<Settings, 2, TestNvm>;
+static_assert(SettingsArea::geometry::slot_size == LFTL_PAGE_SIZE, "unexpected slot size");
+static_assert(SettingsArea::geometry::meta_offset + SettingsArea::geometry::meta_size == SettingsArea::geometry::slot_size, "unexpected meta offset");
+static_assert(SettingsArea::area_size == sizeof(lftl::Storage<Settings, 2, TestNvm>), "unexpected storage size");
+
+SettingsArea settings = LFTL_CPP_AREA_INIT(SettingsArea, nvm_cpp_pages, throw_exception);
+
+static Settings settings_model;
+static Settings settings_model_previous;
+static bool settings_model_active = false;
+
+static void settings_check(){
+  Settings actual;
+  settings.read(actual);
+  if(memcmp(&actual,&settings_model,sizeof(actual))) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+
+static void area_test(){
+  DEBUG_PRINTLN("area_test");
+  settings_model_active = false;
+  if(SettingsArea::area_size > nvm_cpp_pages_size) throw_exception(ERROR_VERIFICATION_FAIL);
+  if(&settings.ctx != lftl_get_ctx(settings.ctx.area)) settings.register_area();
+  settings.format();
+  settings.read(settings_model);
+  settings_model_previous = settings_model;
+  settings_model_active = true;
+  for(uint32_t i=0;i<4;i++){
+    settings_model_previous = settings_model;
+    settings_model.boot_count = i + 1;
+    settings.write<&Settings::boot_count>(settings_model.boot_count);
+    if(settings_model.boot_count != settings.read<&Settings::boot_count>()) throw_exception(ERROR_VERIFICATION_FAIL);
+    //unaligned element of an array
+    settings_model_previous = settings_model;
+    settings_model.key[3*i+1] = (uint8_t)(0xA0 + i);
+    settings.write<&Settings::key>(3*i+1,settings_model.key[3*i+1]);
+    if(settings_model.key[3*i+1] != settings.read<&Settings::key>(3*i+1)) throw_exception(ERROR_VERIFICATION_FAIL);
+    settings_check();
+  }
+  const uint16_t flags[4] = {1,2,3,4};
+  settings_model_previous = settings_model;
+  memcpy(settings_model.flags,flags,sizeof(flags));
+  settings.write<&Settings::flags>(flags);
+  uint16_t actual_flags[4];
+  settings.read<&Settings::flags>(actual_flags);
+  if(memcmp(flags,actual_flags,sizeof(flags))) throw_exception(ERROR_VERIFICATION_FAIL);
+  settings_model_previous = settings_model;
+  settings_model.boot_count = 0x12345678;
+  settings_model.pad = 0x9ABCDEF0;
+  settings.write(settings_model);
+  //simulate a reboot
+  settings.ctx.data = LFTL_INVALID_POINTER;
+  settings_check();
+  settings_model_active = false;
+}
+
+static void transaction_test(){
+  DEBUG_PRINTLN("transaction_test");
+  settings_model_active = false;
+  if(&settings.ctx != lftl_get_ctx(settings.ctx.area)) settings.register_area();
+  settings.format();
+  settings.read(settings_model);
+  settings_model_previous = settings_model;
+  settings_model_active = true;
+  //repeated and unaligned writes are merged and programmed by the commit
+  {
+    lftl::Transaction<SettingsArea> tx(settings);
+    Settings next = settings_model;
+    for(uint32_t i=0;i<4;i++){
+      next.boot_count++;
+      tx.field<&Settings::boot_count>() = tx.field<&Settings::boot_count>() + 1;
+      next.key[2*i+1] = (uint8_t)(0x50 + i);
+      tx.field<&Settings::key>()[2*i+1] = next.key[2*i+1];
+    }
+    if(next.boot_count != tx.field<&Settings::boot_count>()) throw_exception(ERROR_VERIFICATION_FAIL);
+    if(next.key[7] != tx.field<&Settings::key>()[7]) throw_exception(ERROR_VERIFICATION_FAIL);
+    settings_check();//not committed yet
+    settings_model_previous = settings_model;
+    settings_model = next;
+    tx.commit();
+    if(tx.active()) throw_exception(ERROR_VERIFICATION_FAIL);
+  }
+  settings_check();
+  //a moved transaction stays ongoing, it is aborted at the end of the scope
+  {
+    lftl::Transaction<SettingsArea> tx(settings);
+    tx.field<&Settings::pad>() = 0xDEADBEEF;
+    lftl::Transaction<SettingsArea> moved(std::move(tx));
+    if(tx.active() || !moved.active()) throw_exception(ERROR_VERIFICATION_FAIL);
+    moved.field<&Settings::flags>()[1] = 0x1234;
+    if(0xDEADBEEF != moved.field<&Settings::pad>()) throw_exception(ERROR_VERIFICATION_FAIL);
+    if(0x1234 != moved.field<&Settings::flags>()[1]) throw_exception(ERROR_VERIFICATION_FAIL);
+  }
+  if(LFTL_INVALID_POINTER != settings.ctx.transaction_tracker) throw_exception(ERROR_VERIFICATION_FAIL);
+  settings_check();
+  //overlay smaller than the written range, each write unit is written once and evicted
+  {
+    lftl::Transaction<SettingsArea, 1> tx(settings);
+    Settings next = settings_model;
+    for(uint32_t i=0;i<sizeof(next.key);i++) next.key[i] = (uint8_t)(0x30 + i);
+    tx.write<&Settings::key>(next.key);
+    if(next.key[9] != tx.field<&Settings::key>()[9]) throw_exception(ERROR_VERIFICATION_FAIL);
+    settings_model_previous = settings_model;
+    settings_model = next;
+    tx.commit();
+  }
+  settings_check();
+  //RAM mirrors flushed in a single transaction
+  lftl::Persistent<SettingsArea, &Settings::boot_count> boot_count(settings);
+  lftl::Persistent<SettingsArea, &Settings::pad> pad(settings);
+  boot_count.load();
+  pad.load();
+  if(boot_count.get() != settings_model.boot_count) throw_exception(ERROR_VERIFICATION_FAIL);
+  boot_count = boot_count + 1;
+  pad = 0x600DF00D;
+  boot_count = boot_count + 1;
+  settings_model_previous = settings_model;
+  settings_model.boot_count += 2;
+  settings_model.pad = 0x600DF00D;
+  lftl::flush(settings, boot_count, pad);
+  if(boot_count.dirty() || pad.dirty()) throw_exception(ERROR_VERIFICATION_FAIL);
+  settings_check();
+  pad = 0;
+  settings_model_previous = settings_model;
+  settings_model.pad = 0;
+  pad.flush<1>();
+  //simulate a reboot
+  settings.ctx.data = LFTL_INVALID_POINTER;
+  settings_check();
+  settings_model_active = false;
+}
+
+#if defined(HAS_ASYNC_NVM) && defined(LFTL_CPP_COROUTINES)
+static lftl_async_t settings_async = {nvm_start_erase, nvm_start_write, nvm_poll_busy, 0, {}};
+static bool async_done;
+static unsigned int async_steps;
+
+//some other work for the executor
+static lftl::Task work_task(){
+  while(!async_done){
+    async_steps++;
+    co_await lftl::yield();
+  }
+}
+
+static lftl::Task settings_task(){
+  for(uint32_t i=0;i<3;i++){
+    settings_model_previous = settings_model;
+    settings_model.boot_count++;
+    co_await settings.async_write<&Settings::boot_count>(settings_model.boot_count);
+    settings_model_previous = settings_model;
+    settings_model.key[2*i+1] = (uint8_t)(0xC0 + i);
+    co_await settings.async_write<&Settings::key>(2*i+1, settings_model.key[2*i+1]);
+  }
+  uint64_t tracker[SIZE64(SettingsArea::tracker_size)];
+  co_await settings.async_transaction_start(tracker);
+  Settings next = settings_model;
+  next.pad = 0xA5A5F00D;
+  next.flags[2] = 0x4321;
+  co_await settings.async_write<&Settings::pad>(next.pad);
+  co_await settings.async_write<&Settings::flags>(2, next.flags[2]);
+  settings_check();//not committed yet
+  settings_model_previous = settings_model;
+  settings_model = next;
+  co_await settings.async_commit();
+  async_done = true;
+}
+
+//a torn run leaks its coroutine frames: they are not at a suspension point so they cannot be destroyed
+static void async_test(){
+  DEBUG_PRINTLN("async_test");
+  settings_model_active = false;
+  lftl::AsyncOp::reset();
+  settings.ctx.async = &settings_async;
+  if(&settings.ctx != lftl_get_ctx(settings.ctx.area)) settings.register_area();
+  settings.format();
+  settings.read(settings_model);
+  settings_model_previous = settings_model;
+  settings_model_active = true;
+  async_done = false;
+  lftl::Task task = settings_task();
+  lftl::Task work = work_task();
+  lftl::run(task, work);
+  if(!task.done() || !work.done()) throw_exception(ERROR_VERIFICATION_FAIL);
+  //simulate a reboot
+  settings.ctx.data = LFTL_INVALID_POINTER;
+  settings_check();
+  settings_model_active = false;
+}
+
+//same writes, blocking the executor while the NVM is busy
+static lftl::Task bench_blocking_task(unsigned int n_writes){
+  for(uint32_t i=0;i<n_writes;i++){
+    lftl_async_write(&settings.ctx, settings.addr<&Settings::boot_count>(), &i, sizeof(i));
+    while(LFTL_ASYNC_BUSY == lftl_async_poll(&settings.ctx));
+    co_await lftl::yield();
+  }
+  async_done = true;
+}
+
+static lftl::Task bench_async_task(unsigned int n_writes){
+  for(uint32_t i=0;i<n_writes;i++){
+    co_await settings.async_write<&Settings::boot_count>(i);
+  }
+  async_done = true;
+}
+
+//executor throughput while the NVM is busy
+static void async_bench(){
+  DEBUG_PRINTLN("async_bench");
+  const unsigned int n_writes = 16;
+  const uint32_t erase_busy_us = nvm_erase_busy_us;
+  const uint32_t write_busy_us = nvm_write_busy_us;
+  //latencies given on the command line, or typical flash ones
+  if(0 == nvm_erase_busy_us) nvm_erase_busy_us = 2000;
+  if(0 == nvm_write_busy_us) nvm_write_busy_us = 2;
+  lftl::AsyncOp::reset();
+  settings.ctx.async = &settings_async;
+  if(&settings.ctx != lftl_get_ctx(settings.ctx.area)) settings.register_area();
+  settings.format();
+  async_done = false;
+  async_steps = 0;
+  {
+    lftl::Task task = bench_blocking_task(n_writes);
+    lftl::Task work = work_task();
+    lftl::run(task, work);
+  }
+  const unsigned int blocking_steps = async_steps;
+  async_done = false;
+  async_steps = 0;
+  {
+    lftl::Task task = bench_async_task(n_writes);
+    lftl::Task work = work_task();
+    lftl::run(task, work);
+  }
+  const unsigned int async_steps_done = async_steps;
+  nvm_erase_busy_us = erase_busy_us;
+  nvm_write_busy_us = write_busy_us;
+  if(n_writes - 1 != settings.read<&Settings::boot_count>()) throw_exception(ERROR_VERIFICATION_FAIL);
+  PRINTLN("%u writes, executor steps of other tasks:",n_writes);
+  PRINTLN("  blocking writes: %8u",blocking_steps);
+  PRINTLN("  co_await writes: %8u",async_steps_done);
+  if(async_steps_done <= blocking_steps) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+#endif
+
+//after a simulated tearing, the area holds the data before or after the interrupted write
+//the transaction of a torn lftl::Transaction is not aborted: its destructor is skipped by longjmp
+void cpp_tearing_check(){
+  settings.ctx.data = LFTL_INVALID_POINTER;
+  settings.ctx.transaction_tracker = LFTL_INVALID_POINTER;
+  settings.ctx.overlay = 0;
+  settings.ctx.next_data = 0;
+  if(!settings_model_active) return;
+  settings_model_active = false;
+  Settings actual;
+  settings.read(actual);
+  if(memcmp(&actual,&settings_model,sizeof(actual)) && memcmp(&actual,&settings_model_previous,sizeof(actual))){
+    PRINTF("C++ area corrupted\n");
+    abort();
+  }
+}
+
+void cpp_seq(){
+  DEBUG_PRINTLN("cpp_seq");
+  test_and_simulate_tearing(area_test);
+  test_and_simulate_tearing(transaction_test);
+  #if defined(HAS_ASYNC_NVM) && defined(LFTL_CPP_COROUTINES)
+  test_and_simulate_tearing(async_test);
+  //not under tearing simulation: the NVM is given typical latencies
+  run_once(async_bench);
+  #endif
+}
@@ -10,6 +10,21 @@
   #define LFTL_WU_MAX_SIZE 128 
 #endif
 
+/// Number of areas held in the address lookup index, further areas are searched linearly.
+#ifndef LFTL_MAX_AREAS
+  #define LFTL_MAX_AREAS 16
+#endif
+
+#define LFTL_META_N_ITEMS 3
+
+/// Number of additional meta data items in slots of pooled areas, see ::lftl_pool_t.
+#define LFTL_POOL_META_N_ITEMS 2
+
+#ifndef SIZE64
+/// Convert a size in bytes into the minimum number of ``uint64_t``.
+#define SIZE64(size) (((size)+7)/8)
+#endif
+
 /// Compute the size required for ``transaction_tracker``. 
 /// See ::lftl_transaction_start.
 /// \param data_size   Size of the data in the target LFTL area, in bytes
@@ -26,6 +41,39 @@
 #define LFTL_TRANSACTION_TRACKER_SIZE(ctx) \
   LFTL_TRANSACTION_TRACKER_SIZE_LL((ctx)->data_size,(ctx)->nvm_props->write_size)
 
+/// Compute the size required for ``transaction_tracker`` from the configuration of an area.
+/// Use it with ::lftl_area_t, which does not hold ``data_size`` nor ``nvm_props``.
+/// \param cfg  Pointer to lftl_area_cfg_t
+///
+#define LFTL_TRANSACTION_TRACKER_SIZE_CFG(cfg) \
+  LFTL_TRANSACTION_TRACKER_SIZE_LL((cfg)->data_size,(cfg)->nvm_props->write_size)
+
+/// Compute the size required for a compact ``transaction_tracker``. 
+/// See ::lftl_transaction_start_compact.
+/// \param n_ranges  Maximum number of disjoint ranges of write units written during a transaction
+///
+#define LFTL_COMPACT_TRACKER_SIZE(n_ranges) (2*sizeof(uint32_t)*((n_ranges)+1))
+
+/// Compute the size of one entry of an overlay, see ::lftl_overlay_t.
+/// \param write_size  Size of the minimum write unit in the NVM, in bytes
+///
+#define LFTL_OVERLAY_ENTRY_SIZE_LL(write_size) (sizeof(uint32_t)+(((write_size)+3)/4)*4)
+
+/// Compute the size required for the ``entries`` buffer of an overlay, see ::lftl_overlay_t.
+/// \param ctx        Pointer to lftl_ctx_t
+/// \param n_entries  Number of write units cached by the overlay
+///
+#define LFTL_OVERLAY_SIZE(ctx,n_entries) \
+  ((n_entries)*LFTL_OVERLAY_ENTRY_SIZE_LL((ctx)->nvm_props->write_size))
+
+/// Compute the size required for the ``entries`` buffer of an overlay from the configuration of an area.
+/// Use it with ::lftl_area_t, see ::LFTL_TRANSACTION_TRACKER_SIZE_CFG.
+/// \param cfg        Pointer to lftl_area_cfg_t
+/// \param n_entries  Number of write units cached by the overlay
+///
+#define LFTL_OVERLAY_SIZE_CFG(cfg,n_entries) \
+  ((n_entries)*LFTL_OVERLAY_ENTRY_SIZE_LL((cfg)->nvm_props->write_size))
+
 /// @name Return codes
 /// @{
 
@@ -51,12 +99,52 @@
 #define LFTL_ERROR_TRANSACTION_OVERWRITE 0x09
 /// Error: the write unit size is too large, max is defined by LFTL_WU_MAX_SIZE
 #define LFTL_ERROR_WU_SIZE_TOO_LARGE 0x0A
+/// Error: an API call is attempted while an asynchronous operation is on-going on the same LFTL area
+#define LFTL_ERROR_ASYNC_ONGOING 0x0B
+/// Error: an asynchronous API call is attempted on an LFTL area without asynchronous accessors
+#define LFTL_ERROR_NO_ASYNC 0x0C
+/// Error: an API call is attempted while a stream is on-going on the same LFTL area
+#define LFTL_ERROR_STREAM_ONGOING 0x0D
+/// Error: a stream API call is attempted without the matching ::lftl_stream_begin
+#define LFTL_ERROR_NO_STREAM 0x0E
+/// Error: the compact transaction tracker cannot hold more ranges
+#define LFTL_ERROR_TRACKER_FULL 0x0F
+/// Error: a group API call is attempted with an LFTL area which does not belong to the group
+#define LFTL_ERROR_NOT_IN_GROUP 0x10
+/// Error: the configuration of a pool is invalid, see ::lftl_pool_t
+#define LFTL_ERROR_POOL_CONFIG 0x11
+/// Error: a pool does not have any free slot
+#define LFTL_ERROR_POOL_FULL 0x12
+/// Error: an area does not match the compile time configuration of a ``LFTL_STATIC_CONFIG`` build
+#define LFTL_ERROR_STATIC_CONFIG 0x13
+/// Error: ::lftl_get_ptr is called on an NVM which is not memory mapped
+#define LFTL_ERROR_NOT_MAPPED 0x14
+/// Error: a key-value store cannot hold the new value, see ::lftl_kv_set
+#define LFTL_ERROR_KV_FULL 0x15
+/// Error: invalid key, value size or configuration of a key-value store, see ::lftl_kv_t
+#define LFTL_ERROR_KV_INVALID 0x16
+/// Error: invalid configuration of a ring log or record too large, see ::lftl_log_t
+#define LFTL_ERROR_LOG_INVALID 0x17
+/// Error: a ring log without ``overwrite`` is full, see ::lftl_log_trim
+#define LFTL_ERROR_LOG_FULL 0x18
+/// Error: invalid configuration of a counter, see ::lftl_counter_t
+#define LFTL_ERROR_COUNTER_INVALID 0x19
+/// Error: the NVM properties of an area do not match its compile time traits, see lean-ftl.hpp
+#define LFTL_ERROR_NVM_TRAITS 0x1A
+/// Error: an overlay has no entries, see ::lftl_transaction_start_overlay
+#define LFTL_ERROR_OVERLAY_INVALID 0x1B
+/// Error: a transaction, a stream or a pool is used by an ::lftl_area_t without ``ops``
+#define LFTL_ERROR_NO_AREA_OPS 0x1C
 /// Base value for errors reported by the erase function. Bits 0 to 7 may give more details.
 #define LFTL_ERROR_LOW_LEVEL_ERASE 0x0100
 /// Base value for error reported by the write function. Bits 0 to 7 may give more details.
 #define LFTL_ERROR_LOW_LEVEL_WRITE 0x0200
 /// Base value for error reported by the read function. Bits 0 to 7 may give more details.
 #define LFTL_ERROR_LOW_LEVEL_READ 0x0300
+/// Base value for error reported by the poll function. Bits 0 to 7 may give more details.
+#define LFTL_ERROR_LOW_LEVEL_POLL 0x0400
+/// Base value for error reported by the copy function. Bits 0 to 7 may give more details.
+#define LFTL_ERROR_LOW_LEVEL_COPY 0x0500
 /// Most likely a bug in LFTL or a hardware level issue
 #define LFTL_INTERNAL_ERROR -1
 /// @}
@@ -70,6 +158,9 @@ typedef struct lftl_nvm_props_struct {
   uintptr_t size;     /**< the size of the entire NVM (used to select between direct access and nvm_read_t) */
   uint32_t write_size;/**< at least what the NVM is supporting, or a multiple of it */
   uint32_t erase_size;/**< at least what the NVM is supporting, or a multiple of it */
+  uint8_t skip_erased;/**< set it to 1 to skip programming of data write units equal to ``erased_value``, 0 otherwise */
+  uint8_t erased_value;/**< value of each byte of the NVM after erasure, used only if ``skip_erased`` is set */
+  uint8_t memory_mapped;/**< set it to 1 if the NVM can be read directly by the CPU, required by ::lftl_get_ptr */
 } lftl_nvm_props_t;
 
 /**
@@ -123,6 +214,25 @@ typedef uint8_t (*nvm_write_t)(void*dst_nvm_addr, const void*const src, uintptr_
  */
 typedef uint8_t (*nvm_read_t)(void* dst, const void*const src_nvm_addr, uintptr_t size);
 
+/**
+ * \brief Callback to copy data within the physical NVM
+ *
+ * It copies one or more bytes from the NVM to the NVM, typically using 
+ * an NVM internal copy-back command or a DMA channel.
+ * 
+ * If `size` = 0 it shall immediately return 0.
+ * 
+ * The source and destination ranges may cross multiple physical page boundaries.
+ * They are guaranteed to not overlap.
+ * 
+ * \param dst_nvm_addr The start address of the destination. It is always aligned on LFTL_WU_SIZE.
+ * \param src_nvm_addr The start address of the source. It is always aligned on LFTL_WU_SIZE.
+ * \param size The size in bytes of the data to copy. It is always a multiple of LFTL_WU_SIZE.
+ * 
+ * \returns 0 or an error code
+ */
+typedef uint8_t (*nvm_copy_t)(void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size);
+
 /**
  * \brief Callback for error handling
  *
@@ -134,10 +244,308 @@ typedef uint8_t (*nvm_read_t)(void* dst, const void*const src_nvm_addr, uintptr_
  */
 typedef void (*error_handler_t)(uint32_t err_code);
 
+/// @name Asynchronous status codes
+/// @{
+
+/// The NVM is idle / the asynchronous operation is completed.
+#define LFTL_ASYNC_DONE 0x00
+/// The NVM is busy / the asynchronous operation is on-going.
+#define LFTL_ASYNC_BUSY 0x01
+/// @}
+
+/**
+ * \brief Callback to start the erasure of physical NVM
+ *
+ * Same as ::nvm_erase_t except that it returns as soon as the 
+ * operation is started. Completion is detected using ::nvm_poll_busy_t.
+ * 
+ * \returns 0 or an error code
+ */
+typedef uint8_t (*nvm_start_erase_t)(void*base_address, unsigned int n_pages);
+
+/**
+ * \brief Callback to start the programming of physical NVM
+ *
+ * Same as ::nvm_write_t except that it returns as soon as the 
+ * operation is started. Completion is detected using ::nvm_poll_busy_t.
+ * 
+ * `src` remains valid and unchanged until the operation completes.
+ * 
+ * \returns 0 or an error code
+ */
+typedef uint8_t (*nvm_start_write_t)(void*dst_nvm_addr, const void*const src, uintptr_t size);
+
+/**
+ * \brief Callback to poll the state of the physical NVM
+ *
+ * It shall not block.
+ * 
+ * \returns ::LFTL_ASYNC_DONE if the NVM is idle, ::LFTL_ASYNC_BUSY if an 
+ * operation is on-going, any other value is an error code.
+ */
+typedef uint8_t (*nvm_poll_busy_t)(void);
+
+/**
+ * \brief Callback to start a copy within the physical NVM
+ *
+ * Same as ::nvm_copy_t except that it returns as soon as the 
+ * operation is started. Completion is detected using ::nvm_poll_busy_t.
+ * 
+ * \returns 0 or an error code
+ */
+typedef uint8_t (*nvm_start_copy_t)(void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size);
+
+/** @struct lftl_job_struct
+ *  State of an operation on an LFTL area.
+ * 
+ *  This is internal to LFTL.
+ */
+typedef struct lftl_job_struct {
+  uint8_t steps;                            /**< Remaining steps, 0 when idle. */
+  uint8_t phase;                            /**< Current phase. */
+  uint8_t*base;                             /**< Base of the slot being written. */
+  uintptr_t head_size;                      /**< Size of data to copy before the written range. */
+  uintptr_t end_offset;                     /**< End of the written range. */
+  uintptr_t offset;                         /**< Write position. */
+  uintptr_t misalignment;                   /**< Misalignment of the first write unit. */
+  const uint8_t*src;                        /**< Source position. */
+  uintptr_t size;                           /**< Remaining size of source data. */
+  void*src_ctx;                             /**< Context to read the source. */
+  uint32_t wu_index;                        /**< Write unit position. */
+  uintptr_t copied;                         /**< Size already copied in the current copy. */
+  uint32_t crc;                             /**< Checksum of the data, when computed on the fly. */
+  uint32_t erase_count;                     /**< Erase count of the slot being written, pooled areas only. */
+  uint64_t wu[SIZE64(LFTL_WU_MAX_SIZE)];    /**< Buffer for partial write units. */
+  uint32_t meta[(LFTL_META_N_ITEMS+LFTL_POOL_META_N_ITEMS)*4];/**< Buffer for meta data. */
+} lftl_job_t;
+
+/** @struct lftl_async_struct
+ *  Asynchronous accessors of an LFTL area, and the state of the 
+ *  on-going asynchronous operation.
+ * 
+ *  User shall initialize the accessors and set `job` to 0.
+ */
+typedef struct lftl_async_struct {
+  nvm_start_erase_t start_erase;  /**< Start erase function for this area. */
+  nvm_start_write_t start_write;  /**< Start write function for this area. */
+  nvm_poll_busy_t poll_busy;      /**< Poll function for this area. */
+  nvm_start_copy_t start_copy;    /**< Optional start copy function for this area, set it to 0 if not supported. */
+  lftl_job_t job;                 /**< Internal state, initialize it to 0. */
+} lftl_async_t;
+
+/** @struct lftl_stream_struct
+ *  State of a stream, see ::lftl_stream_begin.
+ * 
+ *  This is internal to LFTL.
+ */
+typedef struct lftl_stream_struct {
+  lftl_job_t job;                 /**< Internal state. */
+  uintptr_t fill;                 /**< Number of bytes in the partial write unit buffer. */
+} lftl_stream_t;
+
+/** @struct lftl_overlay_struct
+ *  RAM cache of write units for transactions, see ::lftl_transaction_start_overlay.
+ */
+typedef struct lftl_overlay_struct {
+  void *entries;                  /**< Buffer of ::LFTL_OVERLAY_SIZE bytes, aligned on 4 bytes. */
+  uint32_t n_entries;             /**< Number of entries in ``entries``, at least 1. */
+} lftl_overlay_t;
+
+/// @name Trace event types
+/// @{
+
+/// Entry of an API function.
+#define LFTL_TRACE_API_ENTER 0x01
+/// Exit of an API function.
+#define LFTL_TRACE_API_EXIT 0x02
+/// Call of an accessor.
+#define LFTL_TRACE_ACCESSOR_START 0x03
+/// Return of an accessor.
+#define LFTL_TRACE_ACCESSOR_END 0x04
+/// @}
+
+/** @struct lftl_trace_event_struct
+ *  Event passed to ::lftl_trace_hook_t.
+ */
+typedef struct lftl_trace_event_struct {
+  uint8_t type;                   /**< One of the trace event types, such as ::LFTL_TRACE_API_ENTER. */
+  const char*name;                /**< Name of the API function or of the accessor, such as "lftl_write" or "write". */
+  const void*addr;                /**< Target address, 0 if not relevant. */
+  uintptr_t size;                 /**< Size in bytes, or number of pages for erase accessors, 0 if not relevant. */
+  uint32_t timestamp;             /**< Value returned by the clock of the trace, 0 if it has no clock. */
+} lftl_trace_event_t;
+
+struct lftl_ctx_struct;
+
+/**
+ * \brief Callback receiving trace events
+ *
+ * It is called synchronously, it shall be fast and shall not call LFTL functions.
+ * \param ctx The context of the LFTL area
+ * \param event The event, valid only during the call
+ */
+typedef void (*lftl_trace_hook_t)(struct lftl_ctx_struct*ctx, const lftl_trace_event_t*event);
+
+/**
+ * \brief Callback returning a timestamp
+ *
+ * Typically a free running cycle counter, it may wrap around.
+ * \returns the current time in an arbitrary unit
+ */
+typedef uint32_t (*lftl_clock_t)(void);
+
+/** @struct lftl_trace_struct
+ *  Trace hook of an LFTL area.
+ * 
+ *  Events are emitted only if the library is built with ``LFTL_TRACE`` defined.
+ */
+typedef struct lftl_trace_struct {
+  lftl_trace_hook_t hook;         /**< Function receiving the events. */
+  lftl_clock_t clock;             /**< Optional clock for the timestamps, set it to 0 if not used. */
+} lftl_trace_t;
+
+/** Lock hook, see ::lftl_lock_t.
+ * \param handle The ``handle`` member of the ::lftl_lock_t
+ */
+typedef void (*lftl_lock_hook_t)(void*handle);
+
+/** @struct lftl_lock_struct
+ *  Writer lock of an LFTL area, typically an RTOS mutex or a pthread mutex.
+ * 
+ *  Used only if the library is built with ``LFTL_CONCURRENCY`` defined.
+ *  All API functions take the lock except ::lftl_read which never blocks:
+ *  it retries if the current data was switched while it was reading.
+ *  The lock shall be recursive. Areas of a group or of a pool shall share the same lock.
+ *  The error handler is called with the lock held.
+ */
+typedef struct lftl_lock_struct {
+  lftl_lock_hook_t lock;          /**< Function acquiring the lock. */
+  lftl_lock_hook_t unlock;        /**< Function releasing the lock. */
+  void *handle;                   /**< Mutex or any user data passed to ``lock`` and ``unlock``. */
+} lftl_lock_t;
+
+/** @struct lftl_stats_struct
+ *  Statistics of an LFTL area, see ::lftl_get_stats.
+ * 
+ *  Counters are updated only if the library is built with ``LFTL_STATS`` defined.
+ *  User shall initialize all counters to 0.
+ */
+typedef struct lftl_stats_struct {
+  uint64_t logical_bytes_written; /**< Bytes written, erased or appended by the application. */
+  uint64_t programmed_bytes;      /**< Bytes programmed in the NVM, including copies and meta data. */
+  uint64_t read_bytes;            /**< Bytes read from the NVM through ::nvm_read_t. */
+  uint64_t crc_bytes;             /**< Bytes processed by the checksum. */
+  uint32_t erased_pages;          /**< Pages erased. */
+  uint32_t erase_calls;           /**< Calls to the erase accessors. */
+  uint32_t write_calls;           /**< Calls to the write accessors. */
+  uint32_t read_calls;            /**< Calls to the read accessor. */
+  uint32_t copy_calls;            /**< Calls to the copy accessors. */
+  uint32_t mounts;                /**< Searches of the current slot. */
+  uint32_t write_amplification;   /**< ``programmed_bytes`` per 1000 ``logical_bytes_written``, computed by ::lftl_get_stats. */
+} lftl_stats_t;
+
+/** @struct lftl_profile_struct
+ *  Write profile of an LFTL area, see ::lftl_profile_writes.
+ * 
+ *  Counters are updated only if the library is built with ``LFTL_PROFILE`` defined.
+ *  User shall initialize all counters to 0.
+ */
+typedef struct lftl_profile_struct {
+  uint32_t *wu_writes;            /**< Writes of each write unit of the data, ``n_wu`` entries. */
+  uint32_t n_wu;                  /**< Number of entries in ``wu_writes``, write units beyond it are not counted. */
+  uint32_t updates;               /**< Switches of the current slot. */
+} lftl_profile_t;
+
+/** @struct lftl_area_cfg_struct
+ *  Configuration of an LFTL area, it does not change at runtime so it can be const and stay in flash.
+ * 
+ *  Its members are at the same offsets as in ::lftl_ctx_t, so that ::lftl_register_area points the
+ *  ``cfg`` of an ::lftl_ctx_t at the context itself. Leave the ``reserved`` members to 0.
+ * 
+ *  Copies from NVM to NVM use ``copy`` if set. Otherwise they are done by 
+ *  chunks of ``copy_buffer_size`` bytes using ``read`` and ``write`` if 
+ *  ``copy_buffer`` is set. Otherwise ``write`` is called with a source within the NVM.
+ */
+typedef struct lftl_area_cfg_struct {
+  lftl_nvm_props_t*nvm_props;     /**< Properties of the targeted NVM. */
+  void *area;                     /**< Base address of the LFTL area. */
+  uintptr_t area_size;            /**< Total size in bytes of the LFTL area. */
+  void *reserved0;                /**< Runtime state in ::lftl_ctx_t. */
+  uintptr_t data_size;            /**< Size in bytes of the data in this LFTL area. */
+  nvm_erase_t erase;              /**< Erase function for this area. */
+  nvm_write_t write;              /**< Write function for this area. */
+  nvm_read_t read;                /**< Read function for this area. */
+  error_handler_t error_handler;  /**< Error handler function for this area. */
+  void *reserved1[2];             /**< Runtime state in ::lftl_ctx_t. */
+  lftl_async_t *async;            /**< Optional asynchronous accessors, set it to 0 if not used. */
+  nvm_copy_t copy;                /**< Optional copy function for this area, set it to 0 if not supported. */
+  void *copy_buffer;              /**< Optional buffer for copies without ::nvm_copy_t, set it to 0 if not used. */
+  uintptr_t copy_buffer_size;     /**< Size in bytes of ``copy_buffer``. */
+  void *reserved2[2];             /**< Runtime state in ::lftl_ctx_t. */
+  uint8_t reserved3;              /**< Runtime state in ::lftl_ctx_t. */
+  struct lftl_group_struct *group;/**< Optional group this area belongs to, set it to 0 if not used. */
+  struct lftl_pool_struct *pool;  /**< Optional pool this area draws its slots from, set it to 0 if not used. */
+  void *reserved4;                /**< Runtime state in ::lftl_ctx_t. */
+  lftl_stats_t *stats;            /**< Optional statistics, set it to 0 if not used. */
+  lftl_trace_t *trace;            /**< Optional trace hook, set it to 0 if not used. */
+  void *reserved5;                /**< Runtime state in ::lftl_ctx_t. */
+  lftl_lock_t *lock;              /**< Optional writer lock, set it to 0 if not used. */
+  uint32_t reserved6;             /**< Runtime state in ::lftl_ctx_t. */
+  lftl_profile_t *profile;        /**< Optional write profile, set it to 0 if not used. */
+} lftl_area_cfg_t;
+
+/** @struct lftl_area_ops_struct
+ *  State of the transaction or of the stream on-going on an ::lftl_area_t, it shall be in RAM.
+ * 
+ *  Areas which never have a transaction or a stream on-going at the same time may share it.
+ *  Initialize it with ::LFTL_AREA_OPS_INIT.
+ */
+typedef struct lftl_area_ops_struct {
+  void *transaction_tracker;      /**< Initialize it to ::LFTL_INVALID_POINTER. */
+  lftl_stream_t *stream;          /**< Initialize it to 0. */
+  lftl_overlay_t *overlay;        /**< Initialize it to 0. */
+  void *next_data;                /**< Initialize it to 0. */
+  uint8_t compact_tracker;        /**< Initialize it to 0. */
+} lftl_area_ops_t;
+
+/// Initializer of ::lftl_area_ops_t.
+#define LFTL_AREA_OPS_INIT {LFTL_INVALID_POINTER, 0, 0, 0, 0}
+
+/// Tag of the ``cfg`` member of ::lftl_area_t, it tells it apart from an ::lftl_ctx_t.
+#define LFTL_AREA_TAG 1
+
+/** @struct lftl_area_struct
+ *  Compact LFTL area: the runtime state in RAM and a pointer to a const configuration.
+ * 
+ *  Initialize it with ::LFTL_AREA_INIT and pass it to the API using ::LFTL_AREA_CTX.
+ *  ``ops`` is needed only for transactions, streams and pools, it is 0 otherwise.
+ */
+typedef struct lftl_area_struct {
+  const lftl_area_cfg_t *cfg;     /**< Configuration of the area, tagged with ::LFTL_AREA_TAG. */
+  void *data;                     /**< Initialize it to ::LFTL_INVALID_POINTER. */
+  void *next;                     /**< Initialize it ::LFTL_INVALID_POINTER. */
+  struct lftl_registry_struct *registry;/**< Initialize it to 0. */
+  lftl_area_ops_t *ops;           /**< Optional state of transactions and streams, set it to 0 if not used. */
+  uint32_t data_seq;              /**< Initialize it to 0. */
+} lftl_area_t;
+
+/// Initializer of ::lftl_area_t.
+/// \param cfg_ptr  Pointer to its const ::lftl_area_cfg_t
+/// \param ops_ptr  Pointer to an ::lftl_area_ops_t, or 0 if the area does not use transactions, streams nor pools
+#define LFTL_AREA_INIT(cfg_ptr, ops_ptr) {\
+  (const lftl_area_cfg_t*)((const char*)(cfg_ptr) + LFTL_AREA_TAG),\
+  LFTL_INVALID_POINTER, LFTL_INVALID_POINTER, 0, (ops_ptr), 0}
+
 /** @struct lftl_ctx_struct
  *  Structure defining the context for an LFTL area.
  * 
  *  User shall initialize each member before calling any LFTL function.
+ *  The configuration members are those of ::lftl_area_cfg_t, at the same offsets. 
+ *  See ::lftl_area_t to keep the configuration out of RAM.
+ * 
+ *  Copies from NVM to NVM use ``copy`` if set. Otherwise they are done by 
+ *  chunks of ``copy_buffer_size`` bytes using ``read`` and ``write`` if 
+ *  ``copy_buffer`` is set. Otherwise ``write`` is called with a source within the NVM.
  */
 typedef struct lftl_ctx_struct {
   lftl_nvm_props_t*nvm_props;     /**< Properties of the targeted NVM. */
@@ -151,8 +559,161 @@ typedef struct lftl_ctx_struct {
   error_handler_t error_handler;  /**< Error handler function for this area. */
   void *transaction_tracker;      /**< Initialize it ::LFTL_INVALID_POINTER. */
   void *next;                     /**< Initialize it ::LFTL_INVALID_POINTER. */
+  lftl_async_t *async;            /**< Optional asynchronous accessors, set it to 0 if not used. */
+  nvm_copy_t copy;                /**< Optional copy function for this area, set it to 0 if not supported. */
+  void *copy_buffer;              /**< Optional buffer for copies without ::nvm_copy_t, set it to 0 if not used. */
+  uintptr_t copy_buffer_size;     /**< Size in bytes of ``copy_buffer``. */
+  lftl_stream_t *stream;          /**< Initialize it to 0. */
+  lftl_overlay_t *overlay;        /**< Initialize it to 0. */
+  uint8_t compact_tracker;        /**< Initialize it to 0. */
+  struct lftl_group_struct *group;/**< Optional group this area belongs to, set it to 0 if not used. */
+  struct lftl_pool_struct *pool;  /**< Optional pool this area draws its slots from, set it to 0 if not used. */
+  void *next_data;                /**< Initialize it to 0. */
+  lftl_stats_t *stats;            /**< Optional statistics, set it to 0 if not used. */
+  lftl_trace_t *trace;            /**< Optional trace hook, set it to 0 if not used. */
+  struct lftl_registry_struct *registry;/**< Initialize it to 0. */
+  lftl_lock_t *lock;              /**< Optional writer lock, set it to 0 if not used. */
+  uint32_t data_seq;              /**< Initialize it to 0. */
+  lftl_profile_t *profile;        /**< Optional write profile, set it to 0 if not used. */
+  const lftl_area_cfg_t *cfg;     /**< Set it to 0 to use the members above, ::lftl_register_area then points it to the context. */
 } lftl_ctx_t;
 
+/// Context of a compact LFTL area, to pass a ::lftl_area_t to the API.
+#define LFTL_AREA_CTX(area_ptr) ((lftl_ctx_t*)(area_ptr))
+
+/** @struct lftl_registry_struct
+ *  Set of registered LFTL areas, see ::lftl_registry_init.
+ * 
+ *  Source addresses of write functions are resolved within the registry of the
+ *  target area. ::lftl_init_lib and ::lftl_register_area use a default registry.
+ *  All members are private.
+ */
+typedef struct lftl_registry_struct {
+  lftl_ctx_t *first_area;
+  lftl_ctx_t *last_area;
+  lftl_ctx_t *last_hit;
+  lftl_ctx_t *area_index[LFTL_MAX_AREAS];
+  lftl_ctx_t *nvm_index[LFTL_MAX_AREAS];
+  uint32_t n_area_index;
+  uint32_t n_nvm_index;
+  uint8_t has_several_nvms;
+  uint8_t index_full;
+} lftl_registry_t;
+
+/** @struct lftl_group_struct
+ *  Group of LFTL areas updated atomically, see ::lftl_group_transaction_commit.
+ * 
+ *  The ``group`` member of each member context shall point to the group.
+ */
+typedef struct lftl_group_struct {
+  lftl_ctx_t *record;             /**< LFTL area holding the commit record, its data size shall be at least 8 bytes per member. */
+  lftl_ctx_t **members;           /**< LFTL areas of the group. */
+  uint32_t n_members;             /**< Number of LFTL areas in ``members``. */
+} lftl_group_t;
+
+/** @struct lftl_pool_struct
+ *  Pool of slots shared by LFTL areas located in the same NVM, see ::lftl_format.
+ * 
+ *  The pool is made of the pages of all its areas, split in slots of ``slot_size`` bytes.
+ *  Each slot shall be large enough to hold the data of any area plus 
+ *  ::LFTL_META_N_ITEMS + ::LFTL_POOL_META_N_ITEMS meta data items of ``max(4,write_size)`` bytes.
+ *  The ``pool`` member of each area shall point to the pool.
+ */
+typedef struct lftl_pool_struct {
+  lftl_ctx_t **areas;             /**< LFTL areas of the pool. */
+  uint32_t n_areas;               /**< Number of LFTL areas in ``areas``. */
+  uintptr_t slot_size;            /**< Size in bytes of each slot, multiple of the erase size. */
+  uint32_t migrate_threshold;     /**< Erase count difference triggering the migration of cold data, 0 to disable. */
+} lftl_pool_t;
+
+/// Key marking a free entry of a key-value store index, it cannot be used as a key.
+#define LFTL_KV_NO_KEY 0xFFFF
+/// Value size of a deleted key, also returned by ::lftl_kv_get for a missing key.
+#define LFTL_KV_NOT_FOUND 0xFFFF
+/// Maximum size of a value of a key-value store.
+#define LFTL_KV_MAX_VALUE_SIZE 0xFFFE
+
+/** @struct lftl_kv_entry_struct
+ *  Entry of the RAM index of a key-value store, see ::lftl_kv_t.
+ * 
+ *  This is internal to LFTL.
+ */
+typedef struct lftl_kv_entry_struct {
+  uint16_t key;                   /**< Key, ::LFTL_KV_NO_KEY if the entry is free. */
+  uint16_t size;                  /**< Size of the value, ::LFTL_KV_NOT_FOUND if the key is deleted. */
+  uint32_t offset;                /**< Location of the record, in the log or in the LFTL area. */
+} lftl_kv_entry_t;
+
+/** @struct lftl_kv_struct
+ *  Key-value store, see ::lftl_kv_mount.
+ * 
+ *  The LFTL area holds the compacted records and is dedicated to the store. 
+ *  New records are appended to the log, a range of erase units of the same NVM 
+ *  outside of any LFTL area.
+ */
+typedef struct lftl_kv_struct {
+  lftl_ctx_t *ctx;                /**< LFTL area holding the compacted records. */
+  void *log;                      /**< Base address of the log, aligned on the erase size. */
+  uintptr_t log_size;             /**< Size of the log in bytes, multiple of the erase size. */
+  lftl_kv_entry_t *index;         /**< RAM index, its content is built by ::lftl_kv_mount. */
+  uint32_t index_size;            /**< Number of entries in ``index``, power of 2 larger than the number of keys. */
+  uint32_t seq;                   /**< Internal state, set by ::lftl_kv_mount. */
+  uintptr_t log_fill;             /**< Internal state, set by ::lftl_kv_mount. */
+  uintptr_t live_size;            /**< Internal state, set by ::lftl_kv_mount. */
+} lftl_kv_t;
+
+/** @struct lftl_log_struct
+ *  Ring log of records, see ::lftl_log_mount.
+ * 
+ *  The log uses the pages of ``ctx``: its ``area`` and ``area_size`` shall be aligned on
+ *  the erase size and cover at least 2 pages. Its ``data_size`` is ignored and it shall
+ *  not be registered with ::lftl_register_area.
+ */
+typedef struct lftl_log_struct {
+  lftl_ctx_t *ctx;                /**< Context providing the pages, the accessors and the error handler. */
+  uint8_t overwrite;              /**< 1 to drop the oldest records when the log is full, 0 to raise ::LFTL_ERROR_LOG_FULL. */
+  uint32_t head;                  /**< Internal state, set by ::lftl_log_mount. */
+  uint32_t head_seq;              /**< Internal state, set by ::lftl_log_mount. */
+  uintptr_t head_fill;            /**< Internal state, set by ::lftl_log_mount. */
+  uint32_t tail_seq;              /**< Internal state, set by ::lftl_log_mount. */
+  uintptr_t tail_offset;          /**< Internal state, set by ::lftl_log_mount. */
+} lftl_log_t;
+
+/// Size of the base value of a counter in its LFTL area, see ::lftl_counter_t.
+#define LFTL_COUNTER_BASE_SIZE 12
+
+/** @struct lftl_counter_struct
+ *  Monotonic counter, see ::lftl_counter_mount.
+ * 
+ *  Each increment programs one write unit of the region, a range of erase units 
+ *  of the same NVM outside of any LFTL area. The base value is stored in an LFTL area
+ *  and updated only when the region is exhausted.
+ */
+typedef struct lftl_counter_struct {
+  lftl_ctx_t *ctx;                /**< LFTL area holding the base value. */
+  void *base;                     /**< Address of the base value in the LFTL area, it spans ::LFTL_COUNTER_BASE_SIZE bytes. */
+  void *region;                   /**< Base address of the region, aligned on the erase size. */
+  uintptr_t region_size;          /**< Size of the region in bytes, multiple of the erase size. */
+  uint32_t seq;                   /**< Internal state, set by ::lftl_counter_mount. */
+  uint32_t value;                 /**< Internal state, set by ::lftl_counter_mount. */
+  uint32_t count;                 /**< Internal state, set by ::lftl_counter_mount. */
+} lftl_counter_t;
+
+/// Returned by ::lftl_fifo_dequeue when the FIFO is empty.
+#define LFTL_FIFO_EMPTY 0xFFFF
+
+/** @struct lftl_fifo_struct
+ *  Persistent FIFO, see ::lftl_fifo_mount.
+ * 
+ *  The FIFO uses the pages of ``log.ctx`` like a ring log, ``log.overwrite`` is ignored.
+ */
+typedef struct lftl_fifo_struct {
+  lftl_log_t log;                 /**< Ring log holding the entries, only ``ctx`` is set by the user. */
+} lftl_fifo_t;
+
+/// Function called for each record by ::lftl_log_iterate, it returns 0 to continue or 1 to stop.
+typedef uint8_t (*lftl_log_visitor_t)(void*user, const void*record, uint16_t size);
+
 /** @name Meta information API
  * Functions in this group can be called at any time.
  * @{
@@ -228,12 +789,36 @@ void lftl_init_lib();
 ////////////////////////////////////////////////////////////
 void lftl_register_area(lftl_ctx_t*ctx);
 
+////////////////////////////////////////////////////////////
+/// \brief Initialize a registry of LFTL areas
+///
+/// Same as ::lftl_init_lib for a registry other than the default one.
+/// Areas in different registries do not see each other, so independent
+/// sets of areas can be used concurrently, for example one per thread.
+/// \param reg Registry to initialize
+///
+////////////////////////////////////////////////////////////
+void lftl_registry_init(lftl_registry_t*reg);
+
+////////////////////////////////////////////////////////////
+/// \brief Register an LFTL area in a registry
+///
+/// Same as ::lftl_register_area for a registry other than the default one.
+/// An area shall be registered in a single registry.
+/// \param reg Registry initialized with ::lftl_registry_init
+/// \param ctx Context of the LFTL area to register
+///
+////////////////////////////////////////////////////////////
+void lftl_registry_register_area(lftl_registry_t*reg, lftl_ctx_t*ctx);
+
 ////////////////////////////////////////////////////////////
 /// \brief Format an LFTL area
 ///
 /// This call is not covered by anti-tearing, this is the only one.
 /// In order to erase data with anti-tearing, use ::lftl_erase_all or
 /// keep track of operations using a variable in another LFTL area.
+///
+/// If the area belongs to a pool, all areas of the pool are formatted.
 /// \param ctx Context of the target LFTL area
 ///
 ////////////////////////////////////////////////////////////
@@ -258,6 +843,15 @@ void lftl_format(lftl_ctx_t*ctx);//NOT covered by anti-tearing
 ////////////////////////////////////////////////////////////
 lftl_ctx_t*lftl_get_ctx(const void*const addr);
 
+////////////////////////////////////////////////////////////
+/// \brief Same as ::lftl_get_ctx within a given registry
+///
+/// \param reg  Registry to search
+/// \param addr Address to search
+/// \returns a valid LFTL context or LFTL_INVALID_POINTER
+////////////////////////////////////////////////////////////
+lftl_ctx_t*lftl_registry_get_ctx(lftl_registry_t*reg, const void*const addr);
+
 ////////////////////////////////////////////////////////////
 /// \brief Erase all the data of an LFTL area
 ///
@@ -283,6 +877,45 @@ void lftl_erase_all(lftl_ctx_t*ctx);
 ////////////////////////////////////////////////////////////
 void lftl_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker);
 
+////////////////////////////////////////////////////////////
+/// \brief Start a transaction with a compact tracker
+///
+/// Same as ::lftl_transaction_start except that `transaction_tracker` 
+/// records the ranges of write units written during the transaction
+/// rather than one bit per write unit. Its size depends on the number of 
+/// disjoint ranges written rather than on the size of the data, see ::LFTL_COMPACT_TRACKER_SIZE.
+/// Adjacent ranges are merged.
+///
+/// A write which would need more ranges than `transaction_tracker` can hold 
+/// raises ::LFTL_ERROR_TRACKER_FULL before touching the NVM, the transaction
+/// can then be committed or aborted. A `tracker_size` smaller than 
+/// ``LFTL_COMPACT_TRACKER_SIZE(1)`` raises it when the transaction starts.
+///
+/// \param ctx Context of the target LFTL area
+/// \param transaction_tracker Volatile buffer, aligned on 4 bytes
+/// \param tracker_size Size of `transaction_tracker` in bytes
+////////////////////////////////////////////////////////////
+void lftl_transaction_start_compact(lftl_ctx_t*ctx, void *const transaction_tracker, uintptr_t tracker_size);
+
+////////////////////////////////////////////////////////////
+/// \brief Start a transaction with a RAM overlay
+///
+/// Same as ::lftl_transaction_start except that write units written during 
+/// the transaction are cached in `overlay`. Repeated writes to the same 
+/// write unit are merged in RAM and programmed once, at commit or when the 
+/// write unit is evicted from the overlay to make room for another one.
+/// Writing again a write unit after its eviction raises ::LFTL_ERROR_TRANSACTION_OVERWRITE.
+/// An overlay without entries raises ::LFTL_ERROR_OVERLAY_INVALID.
+///
+/// `overlay` is used from this call until a call to
+/// ::lftl_transaction_commit or ::lftl_transaction_abort.
+///
+/// \param ctx Context of the target LFTL area
+/// \param transaction_tracker Volatile buffer, see ::LFTL_TRANSACTION_TRACKER_SIZE
+/// \param overlay Volatile cache of write units
+////////////////////////////////////////////////////////////
+void lftl_transaction_start_overlay(lftl_ctx_t*ctx, void *const transaction_tracker, lftl_overlay_t*overlay);
+
 ////////////////////////////////////////////////////////////
 /// \brief Commit a transaction
 ///
@@ -364,6 +997,500 @@ void lftl_memread(void*dst, const void*const src, uintptr_t size);
 /// \param size         Size in bytes
 ////////////////////////////////////////////////////////////
 void lftl_memread_newer(void*dst, const void*const src, uintptr_t size);
+
+////////////////////////////////////////////////////////////
+/// \brief Get a direct pointer to data of an LFTL area
+///
+/// Zero-copy alternative to ::lftl_read for NVMs which are memory mapped.
+/// The pointer gives the current data, i.e., the data as it was before
+/// the start of any on-going transaction.
+/// It becomes stale after the next write, commit or erase of the area, 
+/// which is detected by comparing ``generation`` with ::lftl_generation.
+/// A stale pointer may point to data being erased.
+/// \param ctx          Context of the target LFTL area
+/// \param nvm_addr     Address of the data, it shall be within the target LFTL area
+/// \param size         Size in bytes of the data
+/// \param generation   Set to the generation of the data, ignored if 0
+/// \returns a pointer to the data in the NVM
+////////////////////////////////////////////////////////////
+const void*lftl_get_ptr(lftl_ctx_t*ctx, const void*const nvm_addr, uintptr_t size, uint32_t*generation);
+
+////////////////////////////////////////////////////////////
+/// \brief Get the generation of the data of an LFTL area
+///
+/// The generation changes each time the current data moves to another slot.
+/// \param ctx          Context of the target LFTL area
+/// \returns the current generation
+////////////////////////////////////////////////////////////
+uint32_t lftl_generation(lftl_ctx_t*ctx);
+
+////////////////////////////////////////////////////////////
+/// \brief Same as ::lftl_memread within a given registry
+///
+/// \param reg          Registry to search
+/// \param dst          Destination address, it shall be in a volatile memory
+/// \param src          Source address
+/// \param size         Size in bytes
+////////////////////////////////////////////////////////////
+void lftl_registry_memread(lftl_registry_t*reg, void*dst, const void*const src, uintptr_t size);
+
+////////////////////////////////////////////////////////////
+/// \brief Same as ::lftl_memread_newer within a given registry
+///
+/// \param reg          Registry to search
+/// \param dst          Destination address, it shall be in a volatile memory
+/// \param src          Source address
+/// \param size         Size in bytes
+////////////////////////////////////////////////////////////
+void lftl_registry_memread_newer(lftl_registry_t*reg, void*dst, const void*const src, uintptr_t size);
+/** @} */
+
+/** @name Asynchronous API
+ * Functions in this group start an operation and return as soon as 
+ * the first NVM operation is started. The operation is then advanced by
+ * calling ::lftl_async_poll until it returns ::LFTL_ASYNC_DONE, 
+ * typically from the main loop or upon the NVM completion interrupt.
+ * 
+ * This allows the application to run other work or to sleep while the NVM is busy.
+ * 
+ * They require the ``async`` member of the context.
+ * Source buffers shall remain valid and unchanged until the operation completes.
+ * While an asynchronous operation is on-going, the target LFTL area can be read
+ * but other write operations raise ::LFTL_ERROR_ASYNC_ONGOING.
+ * 
+ * All functions in this group are covered by anti-tearing.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Start an asynchronous write of aligned or unaligned data
+///
+/// Same as ::lftl_write_any.
+/// \param ctx          Context of the target LFTL area
+/// \param dst_nvm_addr Destination address, it MUST be within the target LFTL area
+/// \param src          Source address, if it is in NVM, it MUST be in the same LFTL area as ctx or outside of any LFTL area
+/// \param size         Size in bytes
+////////////////////////////////////////////////////////////
+void lftl_async_write(lftl_ctx_t*ctx, void*dst_nvm_addr, const void*const src, uintptr_t size);
+
+////////////////////////////////////////////////////////////
+/// \brief Start an asynchronous erasure of all the data of an LFTL area
+///
+/// Same as ::lftl_erase_all.
+/// \param ctx Context of the target LFTL area
+////////////////////////////////////////////////////////////
+void lftl_async_erase_all(lftl_ctx_t*ctx);
+
+////////////////////////////////////////////////////////////
+/// \brief Start a transaction asynchronously
+///
+/// Same as ::lftl_transaction_start.
+/// \param ctx Context of the target LFTL area
+/// \param transaction_tracker Volatile buffer, see ::LFTL_TRANSACTION_TRACKER_SIZE
+////////////////////////////////////////////////////////////
+void lftl_async_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker);
+
+////////////////////////////////////////////////////////////
+/// \brief Commit a transaction asynchronously
+///
+/// Same as ::lftl_transaction_commit.
+/// The transaction_tracker buffer can be discarded once the operation completes.
+/// \param ctx Context of the target LFTL area
+////////////////////////////////////////////////////////////
+void lftl_async_transaction_commit(lftl_ctx_t*ctx);
+
+////////////////////////////////////////////////////////////
+/// \brief Advance the asynchronous operation on an LFTL area
+///
+/// If the NVM is idle, this starts the next NVM operation. 
+/// It never waits for the NVM.
+/// \param ctx Context of the target LFTL area
+/// \returns ::LFTL_ASYNC_BUSY or ::LFTL_ASYNC_DONE
+////////////////////////////////////////////////////////////
+uint8_t lftl_async_poll(lftl_ctx_t*ctx);
+/** @} */
+
+/** @name Group API
+ * Functions in this group update several LFTL areas atomically.
+ * 
+ * Each member stages its new data in its next slot, marked as pending.
+ * A single write to the record area then acknowledges all pending slots 
+ * at once: upon power loss, either all members or none of them are updated.
+ * 
+ * The record area should be formatted together with the members.
+ * 
+ * All functions in this group are covered by anti-tearing.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Start a transaction on each member of a group
+///
+/// Same as calling ::lftl_transaction_start on each member.
+/// Members may also start their transaction individually, using any variant
+/// of ::lftl_transaction_start.
+/// \param group Group of LFTL areas
+/// \param transaction_trackers Volatile buffers, one per member, see ::LFTL_TRANSACTION_TRACKER_SIZE
+////////////////////////////////////////////////////////////
+void lftl_group_transaction_start(lftl_group_t*group, void *const*transaction_trackers);
+
+////////////////////////////////////////////////////////////
+/// \brief Commit atomically the transactions of a group
+///
+/// Members without on-going transaction are left untouched.
+///
+/// Performance considerations: this function writes at most
+/// one slot + meta data per member, and one slot of the record area.
+///
+/// \param group Group of LFTL areas
+////////////////////////////////////////////////////////////
+void lftl_group_transaction_commit(lftl_group_t*group);
+
+////////////////////////////////////////////////////////////
+/// \brief Abort the transactions of a group
+///
+/// \param group Group of LFTL areas
+////////////////////////////////////////////////////////////
+void lftl_group_transaction_abort(lftl_group_t*group);
+/** @} */
+
+/** @name Streaming API
+ * Functions in this group write a range of an LFTL area from sequential
+ * chunks, for objects larger than the available RAM.
+ * 
+ * The chunks are written directly to the next slot and the checksum 
+ * is computed on the fly, no transaction tracker is needed. 
+ * The new data becomes visible only when ::lftl_stream_commit completes.
+ * While a stream is on-going, the target LFTL area can be read
+ * but other write operations raise ::LFTL_ERROR_STREAM_ONGOING.
+ * 
+ * All functions in this group are covered by anti-tearing.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Start a stream
+///
+/// Erase the next slot and copy the data located before ``dst_nvm_addr``.
+/// This function is not allowed when a transaction is on-going.
+/// \param ctx          Context of the target LFTL area
+/// \param stream       Volatile state of the stream, it shall remain valid until the stream is committed or aborted
+/// \param dst_nvm_addr Start address of the range to write, it MUST be within the target LFTL area
+////////////////////////////////////////////////////////////
+void lftl_stream_begin(lftl_ctx_t*ctx, lftl_stream_t*stream, void*dst_nvm_addr);
+
+////////////////////////////////////////////////////////////
+/// \brief Append a chunk of data to a stream
+///
+/// The chunk is written right after the previous one. 
+/// Chunks can have any size, only partial write units are buffered.
+/// \param ctx    Context of the target LFTL area
+/// \param stream State of the stream
+/// \param src    Source address, if it is in NVM, it MUST be in the same LFTL area as ctx or outside of any LFTL area
+/// \param size   Size in bytes
+////////////////////////////////////////////////////////////
+void lftl_stream_append(lftl_ctx_t*ctx, lftl_stream_t*stream, const void*const src, uintptr_t size);
+
+////////////////////////////////////////////////////////////
+/// \brief Commit a stream
+///
+/// Copy the data located after the written range and make the new data visible.
+/// \param ctx    Context of the target LFTL area
+/// \param stream State of the stream
+////////////////////////////////////////////////////////////
+void lftl_stream_commit(lftl_ctx_t*ctx, lftl_stream_t*stream);
+
+////////////////////////////////////////////////////////////
+/// \brief Abort a stream
+///
+/// The data written so far is discarded.
+/// \param ctx    Context of the target LFTL area
+/// \param stream State of the stream
+////////////////////////////////////////////////////////////
+void lftl_stream_abort(lftl_ctx_t*ctx, lftl_stream_t*stream);
+/** @} */
+
+/** @name Key-value API
+ * Functions in this group store small values identified by a 16 bit key.
+ * 
+ * Each update appends a record (key, size, CRC and value) to the log, so
+ * updating a value programs only that record instead of a whole slot.
+ * A RAM index built at mount gives the location of each value.
+ * When the log is full, the live records are compacted into the next slot 
+ * of the LFTL area using the streaming API, then the log is erased.
+ * 
+ * All functions in this group are covered by anti-tearing.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Mount a key-value store
+///
+/// Build the index from the LFTL area and the log. A record torn by a reset 
+/// is dropped and forces a compaction at the next update.
+/// If the LFTL area does not hold a key-value store, for example just after 
+/// ::lftl_format, an empty store is created.
+/// \param kv Key-value store
+////////////////////////////////////////////////////////////
+void lftl_kv_mount(lftl_kv_t*kv);
+
+////////////////////////////////////////////////////////////
+/// \brief Set the value of a key
+///
+/// Nothing is written if the value is unchanged.
+/// Raises ::LFTL_ERROR_KV_FULL before touching the NVM if the compacted
+/// records would not fit in the LFTL area or if the index is full.
+/// \param kv    Key-value store
+/// \param key   Key, any value but ::LFTL_KV_NO_KEY
+/// \param value Value, in RAM
+/// \param size  Size of the value in bytes, up to ::LFTL_KV_MAX_VALUE_SIZE
+////////////////////////////////////////////////////////////
+void lftl_kv_set(lftl_kv_t*kv, uint16_t key, const void*const value, uint16_t size);
+
+////////////////////////////////////////////////////////////
+/// \brief Get the value of a key
+///
+/// \param kv       Key-value store
+/// \param key      Key
+/// \param dst      Destination buffer
+/// \param max_size Size of ``dst``, longer values are truncated
+/// \return Size of the value, ::LFTL_KV_NOT_FOUND if the key is not set
+////////////////////////////////////////////////////////////
+uint16_t lftl_kv_get(lftl_kv_t*kv, uint16_t key, void*dst, uint16_t max_size);
+
+////////////////////////////////////////////////////////////
+/// \brief Delete a key
+///
+/// \param kv  Key-value store
+/// \param key Key
+////////////////////////////////////////////////////////////
+void lftl_kv_delete(lftl_kv_t*kv, uint16_t key);
+
+////////////////////////////////////////////////////////////
+/// \brief Compact a key-value store
+///
+/// Write the live records into the next slot of the LFTL area and erase the log.
+/// This is done automatically when the log is full.
+/// \param kv Key-value store
+////////////////////////////////////////////////////////////
+void lftl_kv_compact(lftl_kv_t*kv);
+/** @} */
+
+/** @name Ring log API
+ * Functions in this group append records to a ring of dedicated pages.
+ * 
+ * Records are programmed sequentially into erased pages, a page is erased only
+ * when the head wraps onto it. Each page starts with a sequence number, the 
+ * head is found at mount by a binary search over them and the tail is recorded
+ * in the head page.
+ * 
+ * All functions in this group are covered by anti-tearing, except ::lftl_log_format.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Format a ring log
+///
+/// Erase all pages of the log. NOT covered by anti-tearing.
+/// \param log Ring log
+////////////////////////////////////////////////////////////
+void lftl_log_format(lftl_log_t*log);
+
+////////////////////////////////////////////////////////////
+/// \brief Mount a ring log
+///
+/// Find the head and the tail of the log. It shall be called before any other
+/// function of this group, except ::lftl_log_format.
+/// \param log Ring log
+////////////////////////////////////////////////////////////
+void lftl_log_mount(lftl_log_t*log);
+
+////////////////////////////////////////////////////////////
+/// \brief Append a record
+///
+/// When the head page is full, the next page is erased. If it holds the oldest
+/// records, they are dropped if ``overwrite`` is set, otherwise 
+/// ::LFTL_ERROR_LOG_FULL is raised before touching the NVM.
+/// \param log    Ring log
+/// \param record Record, in RAM
+/// \param size   Size of the record in bytes, it shall fit in a page along with the page and record headers
+////////////////////////////////////////////////////////////
+void lftl_log_append(lftl_log_t*log, const void*const record, uint16_t size);
+
+////////////////////////////////////////////////////////////
+/// \brief Visit the records from the oldest to the newest
+///
+/// \param log      Ring log
+/// \param visitor  Function called for each record, may be 0 to count the records
+/// \param user     Passed to ``visitor``
+/// \param buf      Buffer receiving each record
+/// \param buf_size Size of ``buf``, longer records are truncated
+/// \return Number of records visited
+////////////////////////////////////////////////////////////
+uint32_t lftl_log_iterate(lftl_log_t*log, lftl_log_visitor_t visitor, void*user, void*buf, uint16_t buf_size);
+
+////////////////////////////////////////////////////////////
+/// \brief Drop the oldest records
+///
+/// The pages are reclaimed only when the head wraps onto them.
+/// \param log       Ring log
+/// \param n_records Number of records to drop, all records are dropped if the log holds less
+////////////////////////////////////////////////////////////
+void lftl_log_trim(lftl_log_t*log, uint32_t n_records);
+/** @} */
+
+/** @name FIFO API
+ * Functions in this group implement a persistent FIFO on a ring of dedicated pages.
+ * 
+ * Enqueuing appends an entry to the ring like ::lftl_log_append, dequeuing programs
+ * a marker write unit of the entry in place. Both cost one program operation, plus
+ * one page erase when the head moves to the next page and one more marker when
+ * the last entry of a page is consumed: the page is then reused when the head wraps onto it.
+ * At mount, the head and the tail pages are found by binary search, only these two pages are scanned.
+ * 
+ * All functions in this group are covered by anti-tearing, except ::lftl_fifo_format.
+ * An entry dequeued just before a reset may be dequeued again.
+ * A marker left partially programmed by such a reset may read as erased during the mount:
+ * the entry is then dequeued once more, and its marker is not programmed again since
+ * a marker write unit is programmed only if it is fully erased. The same holds for page markers.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Format a FIFO
+///
+/// Erase all pages of the FIFO. NOT covered by anti-tearing.
+/// \param fifo FIFO
+////////////////////////////////////////////////////////////
+void lftl_fifo_format(lftl_fifo_t*fifo);
+
+////////////////////////////////////////////////////////////
+/// \brief Mount a FIFO
+///
+/// Find the head and the tail of the FIFO. It shall be called before any other
+/// function of this group, except ::lftl_fifo_format.
+/// \param fifo FIFO
+////////////////////////////////////////////////////////////
+void lftl_fifo_mount(lftl_fifo_t*fifo);
+
+////////////////////////////////////////////////////////////
+/// \brief Enqueue an entry
+///
+/// Raises ::LFTL_ERROR_LOG_FULL before touching the NVM if the next page still holds entries.
+/// \param fifo  FIFO
+/// \param entry Entry, in RAM
+/// \param size  Size of the entry in bytes, it shall fit in a page along with the page and entry headers
+////////////////////////////////////////////////////////////
+void lftl_fifo_enqueue(lftl_fifo_t*fifo, const void*const entry, uint16_t size);
+
+////////////////////////////////////////////////////////////
+/// \brief Dequeue the oldest entry
+///
+/// \param fifo     FIFO
+/// \param dst      Buffer receiving the entry
+/// \param max_size Size of ``dst``, longer entries are truncated
+/// \return Size of the entry, ::LFTL_FIFO_EMPTY if the FIFO is empty
+////////////////////////////////////////////////////////////
+uint16_t lftl_fifo_dequeue(lftl_fifo_t*fifo, void*dst, uint16_t max_size);
+/** @} */
+
+/** @name Counter API
+ * Functions in this group implement monotonic counters such as boot counters 
+ * or anti-rollback counters.
+ * 
+ * An increment programs the next write unit of the region instead of rewriting 
+ * a slot, so a region of one erase unit takes hundreds of increments before it is erased.
+ * The value is the base value plus the number of programmed write units, which 
+ * are found by a binary search at mount. When the region is exhausted, the value
+ * is written as the new base value and the region is erased.
+ * 
+ * All functions in this group are covered by anti-tearing: after a reset during 
+ * ::lftl_counter_increment, the value is the one before or after the increment.
+ * A write unit left partially programmed by such a reset may read as erased during the mount:
+ * ::lftl_counter_increment never programs a write unit which is not fully erased, it counts it 
+ * as consumed so the value may then advance by more than one.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Mount a counter
+///
+/// If the LFTL area does not hold the base value of the counter, for example just after 
+/// ::lftl_format, the counter is created with the value 0.
+/// \param counter Counter
+////////////////////////////////////////////////////////////
+void lftl_counter_mount(lftl_counter_t*counter);
+
+////////////////////////////////////////////////////////////
+/// \brief Get the value of a counter
+///
+/// \param counter Counter
+/// \return Value of the counter
+////////////////////////////////////////////////////////////
+uint32_t lftl_counter_read(lftl_counter_t*counter);
+
+////////////////////////////////////////////////////////////
+/// \brief Increment a counter
+///
+/// \param counter Counter
+/// \return Value of the counter after the increment
+////////////////////////////////////////////////////////////
+uint32_t lftl_counter_increment(lftl_counter_t*counter);
+/** @} */
+
+/** @name Pool API
+ * Areas of a pool draw their slots from the pages of all areas of the pool:
+ * each update uses the least erased free slot, so a frequently updated area
+ * wears the pages of rarely updated ones as well.
+ * 
+ * The erase count of each slot is stored in its meta data. After each update,
+ * if the most erased free slot has been erased more than ``migrate_threshold``
+ * times more than the slot of the least erased idle area, the data of that
+ * area is moved onto it (static wear leveling).
+ * 
+ * Use ::lftl_format to format a pool.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Get the range of erase counts of the slots of a pool
+///
+/// Slots never written since the formatting of the pool are not taken into account.
+/// \param pool Pool of LFTL areas
+/// \param min Output: minimum erase count
+/// \param max Output: maximum erase count
+////////////////////////////////////////////////////////////
+void lftl_pool_erase_counts(lftl_pool_t*pool, uint32_t*min, uint32_t*max);
+/** @} */
+
+/** @name Statistics API
+ * Functions in this group can be called at any time.
+ * @{
+ */
+
+////////////////////////////////////////////////////////////
+/// \brief Get the statistics of an LFTL area
+///
+/// Counters are updated only if the library is built with ``LFTL_STATS``
+/// defined and ``stats`` is set in the context, otherwise they remain at 0.
+/// \param ctx Context of the target LFTL area
+/// \param stats Output: copy of the counters and derived write amplification
+////////////////////////////////////////////////////////////
+void lftl_get_stats(lftl_ctx_t*ctx, lftl_stats_t*stats);
+
+////////////////////////////////////////////////////////////
+/// \brief Get the number of writes of a range of an LFTL area
+///
+/// Counters are updated only if the library is built with ``LFTL_PROFILE``
+/// defined and ``profile`` is set in the context, otherwise it returns 0.
+/// The tool ``tools/lftl-split.py`` uses these counts to propose a split
+/// of the area into hot and cold areas.
+/// \param ctx Context of the target LFTL area
+/// \param nvm_addr Start of the range, within the data of the area
+/// \param size Size in bytes of the range
+/// \return Largest number of writes of the write units of the range
+////////////////////////////////////////////////////////////
+uint32_t lftl_profile_writes(lftl_ctx_t*ctx, const void*const nvm_addr, uintptr_t size);
 /** @} */
 
 /** @name Low level API
@@ -473,13 +1600,6 @@ void lftl_transaction_write_any(lftl_ctx_t*ctx, void*dst_nvm_addr, const void*co
 
 /** @} */
 
-#define LFTL_META_N_ITEMS 3
-
-#ifndef SIZE64
-/// Convert a size in bytes into the minimum number of ``uint64_t``.
-#define SIZE64(size) (((size)+7)/8)
-#endif
-
 #ifndef BITS_PER_BYTE
 /// Number of bits in one byte.
 #define BITS_PER_BYTE 8
@@ -0,0 +1,605 @@
+/*! \file */
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+/// Defined when the C++20 coroutine API is available, see lftl::AsyncOp.
+#define LFTL_CPP_COROUTINES
+#endif
+
+extern "C" {
+#include "lean-ftl.h"
+}
+
+#ifndef LFTL_CPP_OVERLAY_ENTRIES
+  /// Default number of write units cached by the overlay of an lftl::Transaction.
+  #define LFTL_CPP_OVERLAY_ENTRIES 8
+#endif
+
+#ifndef LFTL_CPP_TRANSACTION_MAX_SIZE
+  /// Maximum size in bytes of the buffers of an lftl::Transaction, they are on the stack.
+  #define LFTL_CPP_TRANSACTION_MAX_SIZE 2048
+#endif
+
+/// C++17 wrapper of the C API: the geometry of an area is computed at compile time from the type
+/// of its data and its members are accessed by pointer to member instead of address and size.
+/// With C++20, asynchronous operations are awaitable from coroutines.
+namespace lftl {
+
+/// Division with rounding to ceiling.
+constexpr uintptr_t div_ceil(uintptr_t d, uintptr_t q){ return (d + q - 1) / q; }
+
+/// Round a value to the minimum number of multiples of a unit.
+constexpr uintptr_t round_up(uintptr_t val, uintptr_t unit){ return div_ceil(val, unit) * unit; }
+
+/// Check that a value is a power of 2.
+constexpr bool is_pow2(uintptr_t val){ return (0 != val) && (0 == (val & (val - 1))); }
+
+/** @struct NvmTraits
+ *  Properties and accessors of an NVM, given at compile time.
+ *
+ *  ``Props`` shall hold the same ``write_size`` and ``erase_size`` as ``WriteSize`` and ``PageSize``,
+ *  this is checked by lftl::Area::register_area.
+ */
+template<lftl_nvm_props_t*Props, uint32_t PageSize, uint32_t WriteSize, nvm_erase_t Erase, nvm_write_t Write, nvm_read_t Read>
+struct NvmTraits {
+  static constexpr lftl_nvm_props_t*props = Props;  ///< Properties of the NVM.
+  static constexpr uint32_t page_size = PageSize;   ///< Size in bytes of an erase unit.
+  static constexpr uint32_t write_size = WriteSize; ///< Size in bytes of a write unit.
+  static constexpr nvm_erase_t erase = Erase;       ///< Erase function.
+  static constexpr nvm_write_t write = Write;       ///< Write function.
+  static constexpr nvm_read_t read = Read;          ///< Read function.
+  static_assert(is_pow2(WriteSize), "write size shall be a power of 2");
+  static_assert(WriteSize <= LFTL_WU_MAX_SIZE, "write size is larger than LFTL_WU_MAX_SIZE");
+  static_assert(0 == PageSize % WriteSize, "page size shall be a multiple of the write size");
+};
+
+/// Type of a member given by a pointer to member.
+template<class T> struct member_traits;
+template<class C, class T> struct member_traits<T C::*> {
+  using class_type = C;
+  using type = T;
+};
+
+/** @struct Geometry
+ *  Layout of an LFTL area holding an object of type ``Layout``, computed like the C library does.
+ */
+template<class Layout, unsigned int WearFactor, class Nvm>
+struct Geometry {
+  static_assert(std::is_trivially_copyable<Layout>::value, "Layout shall be trivially copyable");
+  static_assert(WearFactor >= 2, "wear leveling factor shall be at least 2");
+  static_assert(0 == sizeof(Layout) % Nvm::write_size, "Layout shall be padded to a multiple of the write size");
+  static constexpr uintptr_t data_size = sizeof(Layout);                                        ///< Size in bytes of the data.
+  static constexpr uintptr_t meta_item_size = Nvm::write_size > 4 ? Nvm::write_size : 4;        ///< Size in bytes of a meta data item.
+  static constexpr uintptr_t meta_size = LFTL_META_N_ITEMS * meta_item_size;                    ///< Size in bytes of the meta data of a slot.
+  static constexpr uintptr_t slot_size = round_up(data_size + meta_size, Nvm::page_size);       ///< Size in bytes of a slot.
+  static constexpr uintptr_t meta_offset = slot_size - meta_size;                               ///< Offset of the meta data in a slot.
+  static constexpr unsigned int n_slots = WearFactor;                                           ///< Number of slots.
+  static constexpr uintptr_t area_size = n_slots * slot_size;                                   ///< Size in bytes of the area.
+  static constexpr uintptr_t tracker_size = LFTL_TRANSACTION_TRACKER_SIZE_LL(data_size, Nvm::write_size);///< Size in bytes of a transaction tracker.
+  static_assert(meta_offset >= data_size, "meta data overlaps the data");
+};
+
+/** @struct Storage
+ *  Storage in NVM of an LFTL area holding an object of type ``Layout``.
+ */
+template<class Layout, unsigned int WearFactor, class Nvm>
+struct alignas(Nvm::page_size) Storage {
+  uint8_t pages[Geometry<Layout, WearFactor, Nvm>::area_size];
+};
+
+#ifdef LFTL_CPP_COROUTINES
+/** @class AsyncOp
+ *  Awaitable asynchronous operation on an LFTL area, see ::lftl_async_poll.
+ *
+ *  A coroutine awaiting an operation is suspended until lftl::AsyncOp::poll finds it completed,
+ *  so the executor runs other coroutines while the NVM is busy. The executor of the application
+ *  calls lftl::AsyncOp::poll from its loop, lftl::run is a minimal executor.
+ *  An operation without area completes as soon as it is polled, see lftl::yield.
+ *
+ *  Suspended operations are kept in a single list: all of them shall be polled from the same thread.
+ */
+class [[nodiscard]] AsyncOp {
+public:
+  explicit AsyncOp(lftl_ctx_t*ctx) : ctx_(ctx), next_(nullptr) {}
+  AsyncOp(const AsyncOp&) = delete;
+  AsyncOp&operator=(const AsyncOp&) = delete;
+
+  bool await_ready(){ return (nullptr != ctx_) && (LFTL_ASYNC_DONE == lftl_async_poll(ctx_)); }
+  void await_suspend(std::coroutine_handle<> handle){
+    handle_ = handle;
+    enqueue();
+  }
+  void await_resume(){}
+
+  /// Advance the suspended operations and resume the coroutines of the completed ones.
+  /// \returns the number of operations still on-going
+  static unsigned int poll(){
+    AsyncOp*op = head_;
+    head_ = nullptr;
+    tail_ = nullptr;
+    unsigned int n_busy = 0;
+    while(op){
+      AsyncOp*next = op->next_;
+      if((nullptr == op->ctx_) || (LFTL_ASYNC_DONE == lftl_async_poll(op->ctx_))){
+        op->handle_.resume();
+      } else {
+        op->enqueue();
+        n_busy++;
+      }
+      op = next;
+    }
+    return n_busy;
+  }
+
+  /// Check if some coroutines are suspended on an operation.
+  static bool pending(){ return nullptr != head_; }
+
+  /// Forget the suspended operations, for example after an error handler which does not return.
+  static void reset(){
+    head_ = nullptr;
+    tail_ = nullptr;
+  }
+
+private:
+  void enqueue(){
+    next_ = nullptr;
+    if(tail_) tail_->next_ = this;
+    else head_ = this;
+    tail_ = this;
+  }
+
+  lftl_ctx_t*ctx_;
+  AsyncOp*next_;
+  std::coroutine_handle<> handle_;
+  inline static AsyncOp*head_ = nullptr;
+  inline static AsyncOp*tail_ = nullptr;
+};
+
+/// Let the other coroutines run.
+inline AsyncOp yield(){ return AsyncOp(nullptr); }
+
+/** @class Task
+ *  Coroutine run by lftl::run, it is created suspended and destroyed with the task.
+ */
+class Task {
+public:
+  struct promise_type {
+    Task get_return_object(){ return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void(){}
+    void unhandled_exception(){ std::terminate(); }
+  };
+
+  Task(Task&&other) : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task(const Task&) = delete;
+  Task&operator=(const Task&) = delete;
+  ~Task(){ if(handle_) handle_.destroy(); }
+
+  /// Run the coroutine until its first suspension.
+  void start(){ handle_.resume(); }
+
+  /// Check if the coroutine returned.
+  bool done() const { return !handle_ || handle_.done(); }
+
+private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+  std::coroutine_handle<promise_type> handle_;
+};
+
+/// Minimal executor: start the tasks and poll their operations until none is suspended.
+template<class... Tasks>
+void run(Tasks&... tasks){
+  (tasks.start(), ...);
+  while(AsyncOp::pending()) AsyncOp::poll();
+}
+#endif
+
+/** @struct Area
+ *  LFTL area holding an object of type ``Layout``.
+ *
+ *  The area is an aggregate so that a global is initialized at compile time like
+ *  a C ::lftl_ctx_t, declare it with ::LFTL_CPP_AREA_INIT.
+ *  Pools are not supported, their slots do not follow the geometry computed here.
+ *
+ *  ``StorageAddr`` is the address of the storage if it is known at compile time, the
+ *  addresses of members are then constants like with the C macros. Otherwise they
+ *  are computed from ``ctx.area``.
+ *
+ *  Example:
+ *  \code{.cpp}
+ *  struct Settings { uint32_t boot_count; uint8_t key[16]; uint32_t pad[3]; };
+ *  using MyNvm = lftl::NvmTraits<&nvm_props, 4096, 16, nvm_erase, nvm_write, nvm_read>;
+ *  lftl::Storage<Settings, 2, MyNvm> settings_storage __attribute__ ((section (".data_flash")));
+ *  using SettingsArea = lftl::Area<Settings, 2, MyNvm, &settings_storage>;
+ *  SettingsArea settings = LFTL_CPP_AREA_INIT(SettingsArea, &settings_storage, error_handler);
+ *
+ *  settings.register_area();
+ *  settings.write<&Settings::boot_count>(settings.read<&Settings::boot_count>() + 1);
+ *  \endcode
+ */
+template<class Layout, unsigned int WearFactor, class Nvm, auto StorageAddr = nullptr>
+struct Area {
+  using layout_type = Layout;
+  using nvm = Nvm;
+  using geometry = Geometry<Layout, WearFactor, Nvm>;
+  static constexpr uintptr_t data_size = geometry::data_size;
+  static constexpr uintptr_t area_size = geometry::area_size;
+  static constexpr uintptr_t tracker_size = geometry::tracker_size;
+
+  /// Type of a member given by a pointer to member of ``Layout``.
+  template<auto Member> using field_t = typename member_traits<decltype(Member)>::type;
+
+  lftl_ctx_t ctx; ///< Context for the C API.
+
+  /// Register the area, see ::lftl_register_area.
+  void register_area(){
+    if((Nvm::props->write_size != Nvm::write_size) || (Nvm::props->erase_size != Nvm::page_size)){
+      ctx.error_handler(LFTL_ERROR_NVM_TRAITS);
+    }
+    lftl_register_area(&ctx);
+  }
+
+  /// Format the area, see ::lftl_format.
+  void format(){ lftl_format(&ctx); }
+
+  /// Address of the data in NVM.
+  Layout* data(){
+    if constexpr (nullptr != StorageAddr) return reinterpret_cast<Layout*>(StorageAddr);
+    else return static_cast<Layout*>(ctx.area);
+  }
+
+  /// Address of a member in NVM, to use with the C API.
+  template<auto Member> field_t<Member>* addr(){
+    static_assert(std::is_same<typename member_traits<decltype(Member)>::class_type, Layout>::value, "not a member of Layout");
+    return &(data()->*Member);
+  }
+
+  /// Read a member.
+  template<auto Member> void read(field_t<Member>&dst){ lftl_read(&ctx, &dst, addr<Member>(), sizeof(dst)); }
+
+  /// Read a member which is not an array.
+  template<auto Member> field_t<Member> read(){
+    static_assert(!std::is_array<field_t<Member>>::value, "use read(dst) or read(index) for arrays");
+    field_t<Member> dst;
+    read<Member>(dst);
+    return dst;
+  }
+
+  /// Read an element of an array member.
+  template<auto Member, class T = field_t<Member>, std::enable_if_t<std::is_array<T>::value, int> = 0>
+  std::remove_extent_t<T> read(uintptr_t index){
+    std::remove_extent_t<T> dst;
+    lftl_read(&ctx, &dst, &(*addr<Member>())[index], sizeof(dst));
+    return dst;
+  }
+
+  /// Write a member.
+  template<auto Member> void write(const field_t<Member>&src){ lftl_write(&ctx, addr<Member>(), &src, sizeof(src)); }
+
+  /// Write an element of an array member.
+  template<auto Member, class T = field_t<Member>, std::enable_if_t<std::is_array<T>::value, int> = 0>
+  void write(uintptr_t index, const std::remove_extent_t<T>&src){
+    lftl_write(&ctx, &(*addr<Member>())[index], &src, sizeof(src));
+  }
+
+  /// Read the whole data.
+  void read(Layout&dst){ lftl_read(&ctx, &dst, data(), data_size); }
+
+  /// Write the whole data.
+  void write(const Layout&src){ lftl_write(&ctx, data(), &src, data_size); }
+
+#ifdef LFTL_CPP_COROUTINES
+  // Asynchronous API: each function starts the operation and returns an awaitable,
+  // ``ctx.async`` shall be set. Source buffers shall stay valid until the operation completes,
+  // temporaries live until the end of ``co_await area.async_write<&Layout::member>(value)``.
+
+  /// Start the write of a member, see ::lftl_async_write.
+  template<auto Member> AsyncOp async_write(const field_t<Member>&src){
+    lftl_async_write(&ctx, addr<Member>(), &src, sizeof(src));
+    return AsyncOp(&ctx);
+  }
+
+  /// Start the write of an element of an array member, see ::lftl_async_write.
+  template<auto Member, class T = field_t<Member>, std::enable_if_t<std::is_array<T>::value, int> = 0>
+  AsyncOp async_write(uintptr_t index, const std::remove_extent_t<T>&src){
+    lftl_async_write(&ctx, &(*addr<Member>())[index], &src, sizeof(src));
+    return AsyncOp(&ctx);
+  }
+
+  /// Start the write of the whole data, see ::lftl_async_write.
+  AsyncOp async_write(const Layout&src){
+    lftl_async_write(&ctx, data(), &src, data_size);
+    return AsyncOp(&ctx);
+  }
+
+  /// Start a transaction, see ::lftl_async_transaction_start.
+  /// \param tracker Volatile buffer of ``tracker_size`` bytes, aligned on 8 bytes
+  AsyncOp async_transaction_start(void*tracker){
+    lftl_async_transaction_start(&ctx, tracker);
+    return AsyncOp(&ctx);
+  }
+
+  /// Start the commit of the transaction, see ::lftl_async_transaction_commit.
+  AsyncOp async_commit(){
+    lftl_async_transaction_commit(&ctx);
+    return AsyncOp(&ctx);
+  }
+
+  /// Start the erasure of the data, see ::lftl_async_erase_all.
+  AsyncOp async_erase_all(){
+    lftl_async_erase_all(&ctx);
+    return AsyncOp(&ctx);
+  }
+#endif
+};
+
+/// Default number of write units cached by the overlay of an lftl::Transaction: the whole data
+/// of small areas, at most ::LFTL_CPP_OVERLAY_ENTRIES.
+template<class AreaT> constexpr uintptr_t overlay_entries =
+  AreaT::data_size / AreaT::nvm::write_size < LFTL_CPP_OVERLAY_ENTRIES ? AreaT::data_size / AreaT::nvm::write_size : LFTL_CPP_OVERLAY_ENTRIES;
+
+/** @class Transaction
+ *  Transaction on an lftl::Area, aborted when it goes out of scope unless committed.
+ *
+ *  The transaction owns its tracker and an overlay of ``NEntries`` write units (see
+ *  ::lftl_transaction_start_overlay): writes are batched and repeated writes to the same
+ *  write unit are merged in RAM, they are programmed by the commit. Both are on the stack,
+ *  their size is bounded by ::LFTL_CPP_TRANSACTION_MAX_SIZE.
+ *  When more than ``NEntries`` write units are written, the overlay evicts some of them:
+ *  an evicted write unit shall not be written again, use a larger ``NEntries`` for such transactions.
+ *
+ *  The transaction is move-only, the moved-from object is empty.
+ *  If the error handler does not return, for example if it calls ``longjmp``, the destructor
+ *  is skipped: abort the transaction with ::lftl_transaction_abort where the error is handled.
+ *
+ *  Example:
+ *  \code{.cpp}
+ *  {
+ *    lftl::Transaction<SettingsArea> tx(settings);
+ *    tx.field<&Settings::boot_count>() = tx.field<&Settings::boot_count>() + 1;
+ *    tx.field<&Settings::key>()[3] = 0x5A;
+ *    tx.commit();
+ *  }
+ *  \endcode
+ */
+template<class AreaT, uintptr_t NEntries = overlay_entries<AreaT>>
+class Transaction {
+public:
+  using layout_type = typename AreaT::layout_type;
+  template<auto Member> using field_t = typename AreaT::template field_t<Member>;
+  static_assert(NEntries > 0, "the overlay needs at least one entry");
+  static_assert(SIZE64(AreaT::tracker_size) * sizeof(uint64_t) + NEntries * LFTL_OVERLAY_ENTRY_SIZE_LL(AreaT::nvm::write_size) <= LFTL_CPP_TRANSACTION_MAX_SIZE,
+                "transaction buffers exceed LFTL_CPP_TRANSACTION_MAX_SIZE, reduce NEntries");
+
+  /// Proxy of a member: reads return the data of the transaction, writes go to the transaction.
+  template<class T>
+  class Field {
+  public:
+    Field(Transaction&tx, T*addr) : tx_(tx), addr_(addr) {}
+    /// Read the member.
+    operator T() const {
+      T val;
+      tx_.read(&val, addr_, sizeof(T));
+      return val;
+    }
+    /// Write the member.
+    Field&operator=(const T&val){
+      tx_.write(addr_, &val, sizeof(T));
+      return *this;
+    }
+    Field&operator=(const Field&other){ return *this = static_cast<T>(other); }
+  private:
+    Transaction&tx_;
+    T*addr_;
+  };
+
+  /// Proxy of an array member, its elements are accessed with ``[]``.
+  template<class T, uintptr_t N>
+  class Field<T[N]> {
+  public:
+    Field(Transaction&tx, T(*addr)[N]) : tx_(tx), addr_(addr) {}
+    /// Proxy of an element.
+    Field<T> operator[](uintptr_t index){ return Field<T>(tx_, &(*addr_)[index]); }
+    /// Write the whole array.
+    Field&operator=(const T(&val)[N]){
+      tx_.write(addr_, val, sizeof(val));
+      return *this;
+    }
+  private:
+    Transaction&tx_;
+    T(*addr_)[N];
+  };
+
+  /// Start a transaction on ``area``.
+  explicit Transaction(AreaT&area) : area_(&area) {
+    overlay_.entries = entries_;
+    overlay_.n_entries = NEntries;
+    lftl_transaction_start_overlay(&area.ctx, tracker_, &overlay_);
+  }
+
+  Transaction(const Transaction&) = delete;
+  Transaction&operator=(const Transaction&) = delete;
+
+  /// Take over the transaction of ``other``.
+  Transaction(Transaction&&other) : area_(other.area_) {
+    take(other);
+  }
+
+  /// Abort the current transaction if any and take over the transaction of ``other``.
+  Transaction&operator=(Transaction&&other){
+    if(this != &other){
+      abort();
+      area_ = other.area_;
+      take(other);
+    }
+    return *this;
+  }
+
+  ~Transaction(){ abort(); }
+
+  /// Check if the transaction is ongoing.
+  bool active() const { return nullptr != area_; }
+
+  /// Commit the transaction, see ::lftl_transaction_commit.
+  void commit(){
+    if(nullptr == area_) return;
+    AreaT*area = area_;
+    area_ = nullptr;
+    lftl_transaction_commit(&area->ctx);
+  }
+
+  /// Abort the transaction, see ::lftl_transaction_abort.
+  void abort(){
+    if(nullptr == area_) return;
+    AreaT*area = area_;
+    area_ = nullptr;
+    lftl_transaction_abort(&area->ctx);
+  }
+
+  /// Proxy of a member.
+  template<auto Member> Field<field_t<Member>> field(){
+    return Field<field_t<Member>>(*this, area_->template addr<Member>());
+  }
+
+  /// Write a member.
+  template<auto Member> void write(const field_t<Member>&src){ write(area_->template addr<Member>(), &src, sizeof(src)); }
+
+  /// Read a member, including the writes of the transaction.
+  template<auto Member> void read(field_t<Member>&dst){ read(&dst, area_->template addr<Member>(), sizeof(dst)); }
+
+  /// Write at an address of the area.
+  void write(void*dst_nvm_addr, const void*const src, uintptr_t size){ lftl_transaction_write(&area_->ctx, dst_nvm_addr, src, size); }
+
+  /// Read at an address of the area, including the writes of the transaction.
+  /// Unlike ::lftl_read_newer, the address and size do not need to be aligned.
+  void read(void*dst, const void*const src_nvm_addr, uintptr_t size){
+    constexpr uintptr_t write_size = AreaT::nvm::write_size;
+    uintptr_t offset = reinterpret_cast<uintptr_t>(src_nvm_addr) % write_size;
+    if((0 == offset) && (0 == size % write_size)){
+      lftl_read_newer(&area_->ctx, dst, src_nvm_addr, size);
+      return;
+    }
+    const uint8_t*src8 = static_cast<const uint8_t*>(src_nvm_addr) - offset;
+    uint8_t*dst8 = static_cast<uint8_t*>(dst);
+    while(size){
+      uint8_t wu[write_size];
+      lftl_read_newer(&area_->ctx, wu, src8, write_size);
+      uintptr_t n = write_size - offset;
+      if(n > size) n = size;
+      memcpy(dst8, wu + offset, n);
+      dst8 += n;
+      src8 += write_size;
+      size -= n;
+      offset = 0;
+    }
+  }
+
+private:
+  void take(Transaction&other){
+    other.area_ = nullptr;
+    if(nullptr == area_) return;
+    memcpy(tracker_, other.tracker_, sizeof(tracker_));
+    memcpy(entries_, other.entries_, sizeof(entries_));
+    overlay_.entries = entries_;
+    overlay_.n_entries = NEntries;
+    area_->ctx.transaction_tracker = tracker_;
+    area_->ctx.overlay = &overlay_;
+  }
+
+  AreaT*area_;
+  lftl_overlay_t overlay_;
+  uint64_t tracker_[SIZE64(AreaT::tracker_size)];
+  uint32_t entries_[NEntries * LFTL_OVERLAY_ENTRY_SIZE_LL(AreaT::nvm::write_size) / sizeof(uint32_t)];
+};
+
+/** @class Persistent
+ *  RAM mirror of a member of an lftl::Area.
+ *
+ *  The mirror is read by ::load and modified in RAM, it is marked dirty until it is written back
+ *  by ::flush, or by lftl::flush together with other members in a single transaction.
+ */
+template<class AreaT, auto Member>
+class Persistent {
+public:
+  using value_type = typename AreaT::template field_t<Member>;
+  static_assert(!std::is_array<value_type>::value, "arrays are not supported, wrap them in a struct");
+
+  explicit Persistent(AreaT&area) : area_(area), value_(), dirty_(false) {}
+
+  /// Read the member from NVM, discarding the changes.
+  void load(){
+    area_.template read<Member>(value_);
+    dirty_ = false;
+  }
+
+  /// Value in RAM.
+  const value_type&get() const { return value_; }
+  operator const value_type&() const { return value_; }
+
+  /// Set the value in RAM.
+  Persistent&operator=(const value_type&val){
+    value_ = val;
+    dirty_ = true;
+    return *this;
+  }
+
+  /// Check if the value in RAM differs from NVM.
+  bool dirty() const { return dirty_; }
+
+  /// Write the value to NVM if it is dirty, using a transaction with an overlay of ``NEntries`` write units.
+  template<uintptr_t NEntries = overlay_entries<AreaT>> void flush(){
+    if(!dirty_) return;
+    Transaction<AreaT, NEntries> tx(area_);
+    flush(tx);
+    tx.commit();
+    dirty_ = false;
+  }
+
+  /// Write the value into a transaction if it is dirty, it stays dirty until the commit.
+  template<class TransactionT> void flush(TransactionT&tx){
+    if(dirty_) tx.template write<Member>(value_);
+  }
+
+  /// Mark the value as written to NVM.
+  void clean(){ dirty_ = false; }
+
+private:
+  AreaT&area_;
+  value_type value_;
+  bool dirty_;
+};
+
+/// Write the dirty mirrors of an area in a single transaction with an overlay of ``NEntries`` write units.
+/// Mirrors may share write units: if they span more than ``NEntries`` write units, pass them in address order.
+template<uintptr_t NEntries, class AreaT, class... PersistentT>
+void flush(AreaT&area, PersistentT&... mirrors){
+  if(!(mirrors.dirty() || ...)) return;
+  Transaction<AreaT, NEntries> tx(area);
+  (mirrors.flush(tx), ...);
+  tx.commit();
+  (mirrors.clean(), ...);
+}
+
+/// Write the dirty mirrors of an area in a single transaction.
+template<class AreaT, class... PersistentT>
+void flush(AreaT&area, PersistentT&... mirrors){
+  flush<overlay_entries<AreaT>>(area, mirrors...);
+}
+
+} // namespace lftl
+
+/// Initializer of an lftl::Area, a global is initialized at compile time.
+/// \param area_type      Type of the area, an lftl::Area
+/// \param storage        Address of the storage of the area, typically an lftl::Storage
+/// \param error_handler  Error handler function for this area
+#define LFTL_CPP_AREA_INIT(area_type, storage, error_handler) {{\
+  area_type::nvm::props, (void*)(storage), area_type::area_size, LFTL_INVALID_POINTER, area_type::data_size,\
+  area_type::nvm::erase, area_type::nvm::write, area_type::nvm::read, (error_handler),\
+  LFTL_INVALID_POINTER, LFTL_INVALID_POINTER, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}}
@@ -1,4 +1,5 @@
 #include <string.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -17,28 +18,200 @@
   #define DEBUG_PRINTLN(...)
 #endif
 
+//lftl_ctx_t holds the members of lftl_area_cfg_t at the same offsets
+#define CFG_MEMBER_AT(member) _Static_assert(offsetof(lftl_ctx_t,member) == offsetof(lftl_area_cfg_t,member), "lftl_ctx_t does not hold " #member " like lftl_area_cfg_t")
+CFG_MEMBER_AT(nvm_props);
+CFG_MEMBER_AT(area);
+CFG_MEMBER_AT(area_size);
+CFG_MEMBER_AT(data_size);
+CFG_MEMBER_AT(erase);
+CFG_MEMBER_AT(write);
+CFG_MEMBER_AT(read);
+CFG_MEMBER_AT(error_handler);
+CFG_MEMBER_AT(async);
+CFG_MEMBER_AT(copy);
+CFG_MEMBER_AT(copy_buffer);
+CFG_MEMBER_AT(copy_buffer_size);
+CFG_MEMBER_AT(group);
+CFG_MEMBER_AT(pool);
+CFG_MEMBER_AT(stats);
+CFG_MEMBER_AT(trace);
+CFG_MEMBER_AT(lock);
+CFG_MEMBER_AT(profile);
+//an lftl_area_t starts with its cfg pointer tagged with LFTL_AREA_TAG, an lftl_ctx_t with nvm_props
+_Static_assert(0 == offsetof(lftl_area_t,cfg), "lftl_area_t does not start with cfg");
+_Static_assert((_Alignof(lftl_area_cfg_t) > LFTL_AREA_TAG) && (_Alignof(lftl_nvm_props_t) > LFTL_AREA_TAG), "LFTL_AREA_TAG is not free in pointers");
+
+static inline bool is_area(const lftl_ctx_t*ctx){
+  uintptr_t first;
+  memcpy(&first,ctx,sizeof(first));
+  return first & LFTL_AREA_TAG;
+}
+
+#define AREA(ctx) ((lftl_area_t*)(ctx))
+
+//the registration points the cfg of an lftl_ctx_t at the context itself when it is 0
+#define CFG(ctx) (is_area(ctx) ? (const lftl_area_cfg_t*)((uintptr_t)AREA(ctx)->cfg - LFTL_AREA_TAG) : (ctx)->cfg)
+
+//runtime state of an area, lvalue
+#define ST(ctx,member) (*(is_area(ctx) ? &AREA(ctx)->member : &(ctx)->member))
+
+//state of transactions and streams, lvalue. An lftl_area_t without ops reads it from
+//idle_ops, operations call require_ops before they store anything else than idle values.
+static lftl_area_ops_t idle_ops = LFTL_AREA_OPS_INIT;
+static lftl_area_ops_t*area_ops(lftl_ctx_t*ctx){
+  return AREA(ctx)->ops ? AREA(ctx)->ops : &idle_ops;
+}
+#define OPS(ctx,member) (*(is_area(ctx) ? &area_ops(ctx)->member : &(ctx)->member))
+
+static void require_ops(lftl_ctx_t*ctx){
+  if(is_area(ctx) && (0 == AREA(ctx)->ops)) CFG(ctx)->error_handler(LFTL_ERROR_NO_AREA_OPS);
+}
+
+//called by the entry points which can see a context first: registration and mount of logs, fifos, stores and counters
+static void init_cfg(lftl_ctx_t*ctx){
+  if(is_area(ctx)) return;
+  if(0 == ctx->cfg) ctx->cfg = (const lftl_area_cfg_t*)ctx;
+}
+
+#ifdef LFTL_STATIC_CONFIG
+  //single area build: geometry and accessors are compile time constants
+  #if !defined(LFTL_STATIC_WRITE_SIZE) || !defined(LFTL_STATIC_ERASE_SIZE) || !defined(LFTL_STATIC_AREA_SIZE) || !defined(LFTL_STATIC_DATA_SIZE)
+    #error "LFTL_STATIC_CONFIG requires LFTL_STATIC_WRITE_SIZE, LFTL_STATIC_ERASE_SIZE, LFTL_STATIC_AREA_SIZE and LFTL_STATIC_DATA_SIZE"
+  #endif
+  #if !defined(LFTL_STATIC_ERASE) || !defined(LFTL_STATIC_WRITE) || !defined(LFTL_STATIC_READ)
+    #error "LFTL_STATIC_CONFIG requires LFTL_STATIC_ERASE, LFTL_STATIC_WRITE and LFTL_STATIC_READ"
+  #endif
+  uint8_t LFTL_STATIC_ERASE(void*base_address, unsigned int n_pages);
+  uint8_t LFTL_STATIC_WRITE(void*dst_nvm_addr, const void*const src, uintptr_t size);
+  uint8_t LFTL_STATIC_READ(void* dst, const void*const src_nvm_addr, uintptr_t size);
+  #define WRITE_SIZE(ctx) ((uint32_t)(LFTL_STATIC_WRITE_SIZE))
+  #define ERASE_SIZE(ctx) ((uint32_t)(LFTL_STATIC_ERASE_SIZE))
+  #define AREA_SIZE(ctx) ((uintptr_t)(LFTL_STATIC_AREA_SIZE))
+  #define DATA_SIZE(ctx) ((uintptr_t)(LFTL_STATIC_DATA_SIZE))
+  #define POOL(ctx) ((lftl_pool_t*)0)
+  #define ERASE_ACCESSOR(ctx) LFTL_STATIC_ERASE
+  #define WRITE_ACCESSOR(ctx) LFTL_STATIC_WRITE
+  #define READ_ACCESSOR(ctx) LFTL_STATIC_READ
+#else
+  #define WRITE_SIZE(ctx) (CFG(ctx)->nvm_props->write_size)
+  #define ERASE_SIZE(ctx) (CFG(ctx)->nvm_props->erase_size)
+  #define AREA_SIZE(ctx) (CFG(ctx)->area_size)
+  #define DATA_SIZE(ctx) (CFG(ctx)->data_size)
+  #define POOL(ctx) (CFG(ctx)->pool)
+  #define ERASE_ACCESSOR(ctx) CFG(ctx)->erase
+  #define WRITE_ACCESSOR(ctx) CFG(ctx)->write
+  #define READ_ACCESSOR(ctx) CFG(ctx)->read
+#endif
+
+// Write unit kernels take the write size as first parameter and are always inlined.
+// When the build targets a single write size (LFTL_WU_SIZE), WU_KERNEL also instantiates
+// them with that size as a constant and selects that instance for areas which match it,
+// the generic instance remains for the others. Define LFTL_NO_WU_KERNELS to use only the generic instance.
+#define KERNEL static inline __attribute__((always_inline))
+#if defined(LFTL_WU_SIZE) && !defined(LFTL_STATIC_CONFIG) && !defined(LFTL_NO_WU_KERNELS)
+  _Static_assert((0 == (LFTL_WU_SIZE & (LFTL_WU_SIZE - 1))) && (LFTL_WU_SIZE <= LFTL_WU_MAX_SIZE), "unsupported LFTL_WU_SIZE");
+  #define WU_KERNEL(write_size, kernel, ...) \
+    (((uint32_t)(LFTL_WU_SIZE) == (write_size)) ? kernel((uint32_t)(LFTL_WU_SIZE), __VA_ARGS__) : kernel((write_size), __VA_ARGS__))
+#else
+  #define WU_KERNEL(write_size, kernel, ...) kernel((write_size), __VA_ARGS__)
+#endif
+
+#ifdef LFTL_STATS
+  #define STATS_ADD(ctx,counter,n) do{if(CFG(ctx)->stats) CFG(ctx)->stats->counter += (n);}while(0)
+#else
+  #define STATS_ADD(ctx,counter,n)
+#endif
+
+#ifdef LFTL_PROFILE
+// count the writes of each write unit of the data, offset is relative to the start of the data
+static void profile_write(lftl_ctx_t*ctx, uintptr_t offset, uintptr_t size){
+  lftl_profile_t*const profile = CFG(ctx)->profile;
+  if(0 == profile) return;
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  for(uintptr_t i = offset / write_size; (i < profile->n_wu) && (i * write_size < offset + size); i++){
+    profile->wu_writes[i]++;
+  }
+}
+  #define PROFILE_WRITE(ctx,offset,size) profile_write(ctx,offset,size)
+  #define PROFILE_UPDATE(ctx) do{if(CFG(ctx)->profile) CFG(ctx)->profile->updates++;}while(0)
+#else
+  #define PROFILE_WRITE(ctx,offset,size)
+  #define PROFILE_UPDATE(ctx)
+#endif
+
+#ifdef LFTL_TRACE
+static void trace(lftl_ctx_t*ctx, uint8_t type, const char*name, const void*addr, uintptr_t size){
+  if(0 == CFG(ctx)->trace) return;
+  lftl_trace_event_t event;
+  event.type = type;
+  event.name = name;
+  event.addr = addr;
+  event.size = size;
+  event.timestamp = CFG(ctx)->trace->clock ? CFG(ctx)->trace->clock() : 0;
+  CFG(ctx)->trace->hook(ctx,&event);
+}
+  #define TRACE(ctx,type,name,addr,size) trace(ctx,type,name,addr,size)
+#else
+  #define TRACE(ctx,type,name,addr,size)
+#endif
+#define TRACE_ENTER(ctx,addr,size) TRACE(ctx,LFTL_TRACE_API_ENTER,__func__,addr,size)
+#define TRACE_EXIT(ctx) TRACE(ctx,LFTL_TRACE_API_EXIT,__func__,0,0)
+#define TRACE_START(ctx,name,addr,size) TRACE(ctx,LFTL_TRACE_ACCESSOR_START,name,addr,size)
+#define TRACE_END(ctx,name) TRACE(ctx,LFTL_TRACE_ACCESSOR_END,name,0,0)
+
+#ifdef LFTL_CONCURRENCY
+  #define LOCK(ctx) do{if(CFG(ctx)->lock) CFG(ctx)->lock->lock(CFG(ctx)->lock->handle);}while(0)
+  #define UNLOCK(ctx) do{if(CFG(ctx)->lock) CFG(ctx)->lock->unlock(CFG(ctx)->lock->handle);}while(0)
+#else
+  #define LOCK(ctx)
+  #define UNLOCK(ctx)
+#endif
+
 #define NO_TRANSACTION 0
 #define TRANSACTION 1
 
 #define UNALIGNED 0
 #define ALIGNED 1
 
-static void nvm_erase(lftl_ctx_t*ctx, void*base_address, unsigned int n_pages){
+static void accessor_erase(lftl_ctx_t*ctx, void*base_address, unsigned int n_pages){
   if(0==n_pages) return;
-  uint8_t status = ctx->erase(base_address, n_pages);
-  if(status) ctx->error_handler(LFTL_ERROR_LOW_LEVEL_ERASE | status);
+  STATS_ADD(ctx,erase_calls,1);
+  STATS_ADD(ctx,erased_pages,n_pages);
+  TRACE_START(ctx,"erase",base_address,n_pages);
+  uint8_t status = ERASE_ACCESSOR(ctx)(base_address, n_pages);
+  TRACE_END(ctx,"erase");
+  if(status) CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_ERASE | status);
+}
+
+static void accessor_write(lftl_ctx_t*ctx, void*dst_nvm_addr, const void*const src, uintptr_t size){
+  if(0==size) return;
+  STATS_ADD(ctx,write_calls,1);
+  STATS_ADD(ctx,programmed_bytes,size);
+  TRACE_START(ctx,"write",dst_nvm_addr,size);
+  uint8_t status = WRITE_ACCESSOR(ctx)(dst_nvm_addr, src, size);
+  TRACE_END(ctx,"write");
+  if(status) CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_WRITE | status);
 }
 
-static void nvm_write(lftl_ctx_t*ctx, void*dst_nvm_addr, const void*const src, uintptr_t size){
+static void accessor_read(lftl_ctx_t*ctx, void* dst, const void*const src_nvm_addr, uintptr_t size){
   if(0==size) return;
-  uint8_t status = ctx->write(dst_nvm_addr, src, size);
-  if(status) ctx->error_handler(LFTL_ERROR_LOW_LEVEL_WRITE | status);
+  STATS_ADD(ctx,read_calls,1);
+  STATS_ADD(ctx,read_bytes,size);
+  TRACE_START(ctx,"read",src_nvm_addr,size);
+  uint8_t status = READ_ACCESSOR(ctx)(dst, src_nvm_addr, size);
+  TRACE_END(ctx,"read");
+  if(status) CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_READ | status);
 }
 
-static void nvm_read(lftl_ctx_t*ctx, void* dst, const void*const src_nvm_addr, uintptr_t size){
+static void accessor_copy(lftl_ctx_t*ctx, void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size){
   if(0==size) return;
-  uint8_t status = ctx->read(dst, src_nvm_addr, size);
-  if(status) ctx->error_handler(LFTL_ERROR_LOW_LEVEL_READ | status);
+  STATS_ADD(ctx,copy_calls,1);
+  STATS_ADD(ctx,programmed_bytes,size);
+  TRACE_START(ctx,"copy",dst_nvm_addr,size);
+  uint8_t status = CFG(ctx)->copy(dst_nvm_addr, src_nvm_addr, size);
+  TRACE_END(ctx,"copy");
+  if(status) CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_COPY | status);
 }
 
 static uint32_t crc32c(uint32_t crc, const void*const buf, unsigned int len) {
@@ -68,19 +241,19 @@ static bool is_in_range(const void*const addr, const void*const base, uintptr_t
 }
 
 static bool is_in_nvm(lftl_ctx_t*ctx, const void*const addr){
-  return is_in_range(addr, ctx->nvm_props->base, ctx->nvm_props->size);
+  return is_in_range(addr, CFG(ctx)->nvm_props->base, CFG(ctx)->nvm_props->size);
 }
 
 static void mem_read(lftl_ctx_t*ctx, void*dst, const void*const src, uintptr_t size){
-  if(is_in_nvm(ctx,src)) nvm_read(ctx,dst,src,size);
+  if(is_in_nvm(ctx,src)) accessor_read(ctx,dst,src,size);
   else memcpy(dst,src,size);
 }
 
 
-static uint32_t checksum(lftl_ctx_t*ctx, const void*const src, uintptr_t size){
+static uint32_t checksum_update(lftl_ctx_t*ctx, uint32_t out, const void*const src, uintptr_t size){
+  STATS_ADD(ctx,crc_bytes,size);
   const uint8_t*src8 = (const uint8_t*)src;
   uint64_t buf[16];
-  uint32_t out=0xFFFFFFFF;
   while(size){
     const uint32_t readsize = size > sizeof(buf) ? sizeof(buf) : size;
     mem_read(ctx,buf,src8,readsize);
@@ -91,29 +264,48 @@ static uint32_t checksum(lftl_ctx_t*ctx, const void*const src, uintptr_t size){
   return out;
 }
 
+static uint32_t checksum(lftl_ctx_t*ctx, const void*const src, uintptr_t size){
+  return checksum_update(ctx,0xFFFFFFFF,src,size);
+}
+
 static uintptr_t page_size(lftl_ctx_t*ctx){
-  return ctx->nvm_props->erase_size;
+  return ERASE_SIZE(ctx);
 }
 
 typedef struct lftl_meta_struct { 
   union{
-    uint32_t items[LFTL_META_N_ITEMS];
+    uint32_t items[LFTL_POOL_META_N_ITEMS+LFTL_META_N_ITEMS];
     struct {
+      uint32_t owner;//pooled areas only
+      uint32_t erase_count;//pooled areas only
       uint32_t version;
       uint32_t checksum;
       uint32_t checksum2;
     };
   };
 } lftl_meta_t;
-typedef uint32_t meta_items_worst_case_t[LFTL_META_N_ITEMS*4];//enough to support NVM with write size of 128 bits
+typedef uint32_t meta_items_worst_case_t[(LFTL_POOL_META_N_ITEMS+LFTL_META_N_ITEMS)*4];//enough to support NVM with write size of 128 bits
+
+static unsigned int meta_item_size(lftl_ctx_t*ctx){
+  return max_uintptr(WRITE_SIZE(ctx),sizeof(uint32_t));
+}
+
+// Slots of pooled areas hold the pool items in front of the regular meta data items
+static unsigned int first_meta_item(lftl_ctx_t*ctx){
+  return POOL(ctx) ? 0 : LFTL_POOL_META_N_ITEMS;
+}
+
+static uintptr_t pool_meta_size(lftl_ctx_t*ctx){
+  return (LFTL_POOL_META_N_ITEMS - first_meta_item(ctx)) * meta_item_size(ctx);
+}
 
 static uintptr_t meta_phy_size(lftl_ctx_t*ctx){
-  const unsigned int item_size = max_uintptr(ctx->nvm_props->write_size,sizeof(uint32_t));
-  return LFTL_META_N_ITEMS * item_size;
+  return LFTL_META_N_ITEMS * meta_item_size(ctx) + pool_meta_size(ctx);
 }
 
 static uintptr_t n_pages_in_slot(lftl_ctx_t*ctx){
-  const uintptr_t min_size = ctx->data_size + meta_phy_size(ctx);
+  if(POOL(ctx)) return POOL(ctx)->slot_size / page_size(ctx);
+  const uintptr_t min_size = DATA_SIZE(ctx) + meta_phy_size(ctx);
   const uintptr_t n_pages = (min_size + page_size(ctx)-1) / page_size(ctx);
   return n_pages;
 }
@@ -122,31 +314,75 @@ static uintptr_t slot_size(lftl_ctx_t*ctx){
   return n_pages_in_slot(ctx) * page_size(ctx);
 }
 
+// Slots of a pool are numbered across the areas of the pool, in order
 static unsigned int n_slots(lftl_ctx_t*ctx){
   const uintptr_t size = slot_size(ctx);
-  return ctx->area_size / size;
+  if(0 == POOL(ctx)) return AREA_SIZE(ctx) / size;
+  unsigned int n = 0;
+  for(uint32_t i = 0; i < POOL(ctx)->n_areas; i++){
+    n += AREA_SIZE(POOL(ctx)->areas[i]) / size;
+  }
+  return n;
 }
 
 static uint8_t* slot_base(lftl_ctx_t*ctx, unsigned int slot_index){
-  return ((uint8_t*)ctx->area)+slot_index*slot_size(ctx);
+  const uintptr_t size = slot_size(ctx);
+  if(POOL(ctx)){
+    for(uint32_t i = 0; i < POOL(ctx)->n_areas; i++){
+      const lftl_ctx_t*area = POOL(ctx)->areas[i];
+      const unsigned int n = AREA_SIZE(area) / size;
+      if(slot_index < n) return ((uint8_t*)CFG(area)->area)+slot_index*size;
+      slot_index -= n;
+    }
+  }
+  return ((uint8_t*)CFG(ctx)->area)+slot_index*size;
+}
+
+static unsigned int slot_index_of(lftl_ctx_t*ctx, const void*const base){
+  const uintptr_t size = slot_size(ctx);
+  if(POOL(ctx)){
+    unsigned int first = 0;
+    for(uint32_t i = 0; i < POOL(ctx)->n_areas; i++){
+      const lftl_ctx_t*area = POOL(ctx)->areas[i];
+      if(is_in_range(base, CFG(area)->area, AREA_SIZE(area) - 1)){
+        return first + ((uintptr_t)base - (uintptr_t)CFG(area)->area) / size;
+      }
+      first += AREA_SIZE(area) / size;
+    }
+    CFG(ctx)->error_handler(LFTL_INTERNAL_ERROR);
+  }
+  return ((uintptr_t)base - (uintptr_t)CFG(ctx)->area) / size;
 }
 
 static uintptr_t meta_offset(lftl_ctx_t*ctx){
   return slot_size(ctx) - meta_phy_size(ctx);
 }
 
-static void get_slot_meta(lftl_ctx_t*ctx, lftl_meta_t* dst, unsigned int slot_index){
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  const unsigned int item_size = max_uintptr(write_size,sizeof(uint32_t));
-  const uintptr_t meta_size = LFTL_META_N_ITEMS * item_size;
-  uint32_t*phy_meta = (uint32_t*)(slot_base(ctx, slot_index) + meta_offset(ctx));
-  meta_items_worst_case_t buf;
-  nvm_read(ctx,buf,phy_meta,meta_size);
-  for(unsigned int i = 0; i < LFTL_META_N_ITEMS; i++){
-    dst->items[i] = buf[i*item_size/sizeof(uint32_t)];
+// meta data items are padded to a write unit, or 32 bits if larger
+KERNEL unsigned int meta_item_size_kernel(uint32_t write_size){
+  return write_size > sizeof(uint32_t) ? write_size : sizeof(uint32_t);
+}
+
+KERNEL void unpack_meta_items_kernel(uint32_t write_size, uint32_t*items, const uint32_t*buf, unsigned int n_items){
+  const unsigned int stride = meta_item_size_kernel(write_size) / sizeof(uint32_t);
+  for(unsigned int i = 0; i < n_items; i++){
+    items[i] = buf[i*stride];
   }
 }
 
+static void get_meta_at(lftl_ctx_t*ctx, lftl_meta_t* dst, const uint8_t*base){
+  const unsigned int first = first_meta_item(ctx);
+  meta_items_worst_case_t buf;
+  accessor_read(ctx,buf,base + meta_offset(ctx),meta_phy_size(ctx));
+  dst->owner = 0;
+  dst->erase_count = 0;
+  WU_KERNEL(WRITE_SIZE(ctx),unpack_meta_items_kernel,dst->items + first,buf,LFTL_POOL_META_N_ITEMS+LFTL_META_N_ITEMS-first);
+}
+
+static void get_slot_meta(lftl_ctx_t*ctx, lftl_meta_t* dst, unsigned int slot_index){
+  get_meta_at(ctx,dst,slot_base(ctx, slot_index));
+}
+
 static uint32_t get_slot_version(lftl_ctx_t*ctx, unsigned int slot_index){
   lftl_meta_t meta;
   get_slot_meta(ctx, &meta, slot_index);
@@ -159,10 +395,19 @@ static uint32_t get_slot_checksum(lftl_ctx_t*ctx, unsigned int slot_index){
   return meta.checksum;
 }
 
+// The checksum covers the data, the pool items and the version
+static uint32_t meta_checksum(lftl_ctx_t*ctx, uint32_t data_crc, const lftl_meta_t*meta){
+  if(POOL(ctx)) {
+    STATS_ADD(ctx,crc_bytes,LFTL_POOL_META_N_ITEMS*sizeof(uint32_t));
+    data_crc = crc32c(data_crc,meta->items,LFTL_POOL_META_N_ITEMS*sizeof(uint32_t));
+  }
+  return data_crc + meta->version;
+}
+
 static uint32_t compute_slot_checksum(lftl_ctx_t*ctx, unsigned int slot_index){
   lftl_meta_t meta;
   get_slot_meta(ctx,&meta,slot_index);
-  const uint32_t sum = checksum(ctx,slot_base(ctx, slot_index),ctx->data_size) + meta.version;
+  const uint32_t sum = meta_checksum(ctx,checksum(ctx,slot_base(ctx, slot_index),DATA_SIZE(ctx)),&meta);
   return sum;
 }
 
@@ -170,44 +415,119 @@ static bool slot_integrity_check_ok(lftl_ctx_t*ctx, unsigned int slot_index){
   return get_slot_checksum(ctx,slot_index) == compute_slot_checksum(ctx,slot_index);
 }
 
+// only the n_items padded items are cleared, that is what is written to NVM
+KERNEL void pack_meta_items_kernel(uint32_t write_size, uint32_t*buf, const uint32_t*items, unsigned int n_items){
+  const unsigned int stride = meta_item_size_kernel(write_size) / sizeof(uint32_t);
+  memset(buf,0,n_items*stride*sizeof(uint32_t));
+  for(unsigned int i = 0; i < n_items; i++){
+    buf[i*stride] = items[i];
+  }
+}
+
+static void pack_meta_items(lftl_ctx_t*ctx, uint32_t*buf, const uint32_t*items, unsigned int n_items){
+  WU_KERNEL(WRITE_SIZE(ctx),pack_meta_items_kernel,buf,items,n_items);
+}
+
+static void pack_meta(lftl_ctx_t*ctx, uint32_t*buf, lftl_meta_t*meta){
+  pack_meta_items(ctx,buf,&meta->version,LFTL_META_N_ITEMS);
+}
+
+static void pack_pool_meta(lftl_ctx_t*ctx, uint32_t*buf, lftl_meta_t*meta){
+  pack_meta_items(ctx,buf,meta->items,LFTL_POOL_META_N_ITEMS);
+}
+
+// The pool items are written right after the erasure of the slot, 
+// this writes the regular meta data items
 static void write_meta_core(lftl_ctx_t*ctx, unsigned int slot_index, lftl_meta_t*meta){
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  const unsigned int item_size = max_uintptr(write_size,sizeof(uint32_t));
+  const unsigned int item_size = meta_item_size(ctx);
   const uintptr_t meta_size = LFTL_META_N_ITEMS * item_size;
-  uint8_t*const base = slot_base(ctx, slot_index);
-  lftl_meta_t*meta_phy_addr = (lftl_meta_t*)(base + meta_offset(ctx));
-  meta_items_worst_case_t buf = {0};
-  for(unsigned int i = 0; i < LFTL_META_N_ITEMS; i++){
-    buf[i*item_size/sizeof(uint32_t)] = meta->items[i];
-  }
+  uint8_t*const base = slot_base(ctx, slot_index) + meta_offset(ctx) + pool_meta_size(ctx);
+  meta_items_worst_case_t buf;
+  pack_meta(ctx,buf,meta);
   //write everything but checksum2
-  nvm_write(ctx,meta_phy_addr,buf,meta_size - item_size);
+  accessor_write(ctx,base,buf,meta_size - item_size);
   //write checksum2
   const uintptr_t checksum2_offset = meta_size - item_size;
-  uint32_t*const checksum2_phy_addr = (uint32_t*)(base + meta_offset(ctx) + checksum2_offset);
   uint8_t*const checksum2_src = (uint8_t*)buf + checksum2_offset;
-  nvm_write(ctx,checksum2_phy_addr,checksum2_src,item_size);
+  accessor_write(ctx,base + checksum2_offset,checksum2_src,item_size);
 }
 
 static void write_meta(lftl_ctx_t*ctx, unsigned int slot_index, uint32_t version){
   uint8_t*const base = slot_base(ctx, slot_index);
   lftl_meta_t meta;
+  get_meta_at(ctx,&meta,base);
   meta.version = version;
-  meta.checksum = checksum(ctx,base,ctx->data_size) + meta.version;
+  meta.checksum = meta_checksum(ctx,checksum(ctx,base,DATA_SIZE(ctx)),&meta);
   meta.checksum2 = meta.checksum;
   write_meta_core(ctx,slot_index,&meta);
 }
 
+// Versions of slots staged by a group commit have this bit set 
+// until the group record acknowledges them
+#define VERSION_PENDING 0x80000000
+
+static uint32_t version_number(uint32_t version){
+  return version & ~VERSION_PENDING;
+}
+
+// The group record holds the version number and the checksum of the 
+// acknowledged slot of each member
+typedef uint32_t group_record_item_t[2];
+
+static bool group_acknowledges(lftl_ctx_t*ctx, unsigned int slot_index, uint32_t version){
+  const lftl_group_t*group = CFG(ctx)->group;
+  if(0 == group) return false;
+  for(uint32_t i = 0; i < group->n_members; i++){
+    if(group->members[i] != ctx) continue;
+    group_record_item_t acknowledged;
+    lftl_read(group->record, acknowledged, (group_record_item_t*)CFG(group->record)->area + i, sizeof(acknowledged));
+    if(acknowledged[0] != version_number(version)) return false;
+    return acknowledged[1] == get_slot_checksum(ctx,slot_index);
+  }
+  return false;
+}
+
+static uint32_t pool_owner(lftl_ctx_t*ctx){
+  for(uint32_t i = 0; i < POOL(ctx)->n_areas; i++){
+    if(POOL(ctx)->areas[i] == ctx) return i;
+  }
+  CFG(ctx)->error_handler(LFTL_ERROR_POOL_CONFIG);
+  return 0;
+}
+
+// Switch the current slot. Readers which do not take the lock and pointers from
+// lftl_get_ptr detect the switch using data_seq: a slot is erased only after it
+// stopped being the current one.
+static void set_data(lftl_ctx_t*ctx, void*data){
+#ifdef LFTL_CONCURRENCY
+  __atomic_store_n(&ST(ctx,data), data, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&ST(ctx,data_seq), 1, __ATOMIC_RELEASE);
+#else
+  ST(ctx,data) = data;
+  ST(ctx,data_seq)++;
+#endif
+}
+
 static void find_current_slot(lftl_ctx_t*ctx){
+  STATS_ADD(ctx,mounts,1);
   const unsigned int ns = n_slots(ctx);
   const uint32_t invalid_index = 0xFFFFFFFF;
+  const uint32_t owner = POOL(ctx) ? pool_owner(ctx) : 0;
   uint32_t max_version_index = invalid_index;
   uint32_t max_version = 0;
   for(unsigned int i=0;i<ns;i++){
-    const uint32_t version = get_slot_version(ctx,i);
+    lftl_meta_t meta;
+    get_slot_meta(ctx,&meta,i);
+    uint32_t version = meta.version;
     if(version == 0xFFFFFFFF) continue;
+    if(meta.owner != owner) continue;
+    if(version & VERSION_PENDING){
+      if(!group_acknowledges(ctx,i,version)) continue;
+      version = version_number(version);
+    }
     if(version == max_version) {
-      ctx->error_handler(LFTL_ERROR_VERSION_COLLISION);
+      //in a pool, a torn slot may carry the same version as the valid one
+      if((0 == POOL(ctx)) || slot_integrity_check_ok(ctx,i)) CFG(ctx)->error_handler(LFTL_ERROR_VERSION_COLLISION);
     }
     if(version > max_version) {
       if(slot_integrity_check_ok(ctx,i)){
@@ -217,9 +537,9 @@ static void find_current_slot(lftl_ctx_t*ctx){
     }
   }
   if(invalid_index == max_version_index) {
-    ctx->error_handler(LFTL_ERROR_NO_VALID_VERSION);
+    CFG(ctx)->error_handler(LFTL_ERROR_NO_VALID_VERSION);
   }
-  ctx->data = slot_base(ctx, max_version_index);
+  set_data(ctx, slot_base(ctx, max_version_index));
   //check integrity of checksum2
   lftl_meta_t meta;
   get_slot_meta(ctx, &meta, max_version_index);
@@ -232,15 +552,15 @@ static void find_current_slot(lftl_ctx_t*ctx){
   }
 }
 
-static bool is_in_data(lftl_ctx_t*ctx, const void*const nvm_addr){//nvm_addr is a logical address, so always between ctx->area and ctx->area+data_size
-  return is_in_range(nvm_addr, ctx->area, ctx->data_size);
+static bool is_in_data(lftl_ctx_t*ctx, const void*const nvm_addr){//nvm_addr is a logical address, so always between CFG(ctx)->area and CFG(ctx)->area+data_size
+  return is_in_range(nvm_addr, CFG(ctx)->area, DATA_SIZE(ctx));
 }
 
 static lftl_ctx_t*get_other_ctx(lftl_ctx_t*ctx, const void*const nvm_addr){
   const lftl_ctx_t*stop=ctx;
-  while(ctx->next != stop){
-    if(LFTL_INVALID_POINTER==ctx->next) break;
-    ctx = ctx->next;
+  while(ST(ctx,next) != stop){
+    if(LFTL_INVALID_POINTER==ST(ctx,next)) break;
+    ctx = ST(ctx,next);
     if(is_in_data(ctx,nvm_addr)) return ctx;
   }
   return LFTL_INVALID_POINTER;
@@ -252,22 +572,82 @@ static lftl_ctx_t*get_any_ctx(lftl_ctx_t*ctx, const void*const nvm_addr){
 }
 
 
-bool has_several_nvms = 0;
-lftl_ctx_t*first_area = LFTL_INVALID_POINTER;
-lftl_ctx_t*last_area = LFTL_INVALID_POINTER;
+//Interval index: registered areas sorted by base address of their data range,
+//and one area per NVM sorted by base address of the NVM.
+//Lookups are binary searches, the list of areas is used only if the index is full.
+static lftl_registry_t default_registry = {
+  .first_area = LFTL_INVALID_POINTER,
+  .last_area = LFTL_INVALID_POINTER,
+  .last_hit = LFTL_INVALID_POINTER,
+};
+
+static lftl_registry_t*registry_of(const lftl_ctx_t*ctx){
+  return ST(ctx,registry) ? ST(ctx,registry) : &default_registry;
+}
+
+static uintptr_t index_base(const lftl_ctx_t*ctx, bool nvm){
+  return nvm ? (uintptr_t)CFG(ctx)->nvm_props->base : (uintptr_t)CFG(ctx)->area;
+}
+
+static void index_insert(lftl_ctx_t**index, uint32_t*n, lftl_ctx_t*ctx, bool nvm){
+  uint32_t i = *n;
+  while(i && index_base(index[i-1],nvm) > index_base(ctx,nvm)){
+    index[i] = index[i-1];
+    i--;
+  }
+  index[i] = ctx;
+  (*n)++;
+}
+
+//return the entry with the greatest base lower or equal to addr
+static lftl_ctx_t*index_search(lftl_ctx_t*const*index, uint32_t n, const void*const addr, bool nvm){
+  uint32_t lo = 0;
+  uint32_t hi = n;
+  while(lo<hi){
+    uint32_t mid = lo + (hi-lo)/2;
+    if(index_base(index[mid],nvm) <= (uintptr_t)addr) lo = mid+1;
+    else hi = mid;
+  }
+  return lo ? index[lo-1] : LFTL_INVALID_POINTER;
+}
+
+static lftl_ctx_t*find_area(lftl_registry_t*reg, const void*const addr){
+  if(LFTL_INVALID_POINTER==reg->first_area) return LFTL_INVALID_POINTER;
+#ifdef LFTL_STATIC_CONFIG
+  return is_in_data(reg->first_area,addr) ? reg->first_area : LFTL_INVALID_POINTER;
+#endif
+  if(LFTL_INVALID_POINTER!=reg->last_hit && is_in_data(reg->last_hit,addr)) return reg->last_hit;
+  lftl_ctx_t*ctx;
+  if(reg->index_full){
+    ctx = get_any_ctx(reg->first_area, addr);
+  } else {
+    ctx = index_search(reg->area_index, reg->n_area_index, addr, 0);
+    if(LFTL_INVALID_POINTER!=ctx && !is_in_data(ctx,addr)) ctx = LFTL_INVALID_POINTER;
+  }
+  if(LFTL_INVALID_POINTER!=ctx) reg->last_hit = ctx;
+  return ctx;
+}
 
-static lftl_ctx_t*is_in_any_nvm(const void*const addr){
-  lftl_ctx_t*ctx = first_area;
-  ctx = get_any_ctx(ctx, addr); // we search first within LFTL areas to return the right ctx if several areas use the same NVM.
+static lftl_ctx_t*is_in_any_nvm(lftl_registry_t*reg, const void*const addr){
+  lftl_ctx_t*ctx = find_area(reg, addr); // we search first within LFTL areas to return the right ctx if several areas use the same NVM.
   if(LFTL_INVALID_POINTER!=ctx) return ctx;
   // addr is not in LFTL areas, check other NVM addresses
-  ctx = first_area;
+  if(LFTL_INVALID_POINTER==reg->first_area) return LFTL_INVALID_POINTER;
+#ifdef LFTL_STATIC_CONFIG
+  return is_in_nvm(reg->first_area,addr) ? reg->first_area : LFTL_INVALID_POINTER;
+#endif
+  if(!reg->index_full){
+    ctx = index_search(reg->nvm_index, reg->n_nvm_index, addr, 1);
+    if(LFTL_INVALID_POINTER!=ctx && is_in_nvm(ctx,addr)) return ctx;
+    return LFTL_INVALID_POINTER;
+  }
+  ctx = reg->first_area;
   if(is_in_nvm(ctx,addr)) return ctx;
-  if(has_several_nvms){
+  if(reg->has_several_nvms){
     const lftl_ctx_t*stop=ctx;
-    while(ctx->next != stop){
-      if(LFTL_INVALID_POINTER==ctx->next) break;
-      ctx = ctx->next;
+    while(ST(ctx,next) != stop){
+      if(LFTL_INVALID_POINTER==ST(ctx,next)) break;
+      ctx = ST(ctx,next);
       if(is_in_nvm(ctx,addr)) return ctx;
     }
   }
@@ -275,21 +655,20 @@ static lftl_ctx_t*is_in_any_nvm(const void*const addr){
 }
 
 static void*translate_addr(lftl_ctx_t*ctx, const void*const nvm_addr, uintptr_t size){
-  if(!is_in_data(ctx, nvm_addr)) ctx->error_handler(LFTL_ERROR_FIRST_NOT_IN_DATA);
-  if(LFTL_INVALID_POINTER == ctx->data) find_current_slot(ctx);
-  const uintptr_t offset = (uintptr_t)nvm_addr - (uintptr_t)ctx->area;
-  if(offset+size > ctx->data_size) ctx->error_handler(LFTL_ERROR_LAST_NOT_IN_DATA);
-  return (void*)((uintptr_t)ctx->data + offset);
+  if(!is_in_data(ctx, nvm_addr)) CFG(ctx)->error_handler(LFTL_ERROR_FIRST_NOT_IN_DATA);
+  if(LFTL_INVALID_POINTER == ST(ctx,data)) find_current_slot(ctx);
+  const uintptr_t offset = (uintptr_t)nvm_addr - (uintptr_t)CFG(ctx)->area;
+  if(offset+size > DATA_SIZE(ctx)) CFG(ctx)->error_handler(LFTL_ERROR_LAST_NOT_IN_DATA);
+  return (void*)((uintptr_t)ST(ctx,data) + offset);
 }
 
 static unsigned int get_current_slot_index(lftl_ctx_t*ctx){
-  const uintptr_t offset = (uintptr_t)ctx->data - (uintptr_t)ctx->area;
-  return offset / slot_size(ctx);
+  return slot_index_of(ctx,ST(ctx,data));
 }
 
 static unsigned int next_slot(lftl_ctx_t*ctx){
-  const uintptr_t area_limit = (uintptr_t)ctx->area+ctx->area_size;
-  const uintptr_t next_slot_limit = (uintptr_t)ctx->data + 2*slot_size(ctx); // 1 slot for the current data, 1 slot for the next
+  const uintptr_t area_limit = (uintptr_t)CFG(ctx)->area+AREA_SIZE(ctx);
+  const uintptr_t next_slot_limit = (uintptr_t)ST(ctx,data) + 2*slot_size(ctx); // 1 slot for the current data, 1 slot for the next
   if(next_slot_limit > area_limit ){ // if equal, next slot is the last slot, we will wrap around next time
     return 0; //wrap around
   } else {
@@ -297,398 +676,2279 @@ static unsigned int next_slot(lftl_ctx_t*ctx){
   }
 }
 
-static void erase_slot(lftl_ctx_t*ctx, unsigned int slot_index){
-  void*base = slot_base(ctx, slot_index);
-  nvm_erase(ctx,base,n_pages_in_slot(ctx));
+static uintptr_t n_pages(lftl_ctx_t*ctx){
+  return AREA_SIZE(ctx) / page_size(ctx);
 }
 
-static uintptr_t n_pages(lftl_ctx_t*ctx){
-  return ctx->area_size / page_size(ctx);
+// Erase count of a slot of a pool, 0 if its pool items are not valid
+static uint32_t pool_erase_count(lftl_ctx_t*ctx, const uint8_t*base){
+  lftl_meta_t meta;
+  get_meta_at(ctx,&meta,base);
+  if(meta.owner >= POOL(ctx)->n_areas) return 0;
+  return meta.erase_count;
 }
-/*
-#include <stdio.h>
-void dbg_memcpy(void*dst, const void*const src, uintptr_t size){
-  printf("memcpy: dst=%p, src=%p, size=0x%08lx\n",dst,src,size);
-  uint8_t*dst8 = (uint8_t*)dst;
-  const uint8_t*const src8 = (uint8_t*)src;
-  for(unsigned int i = 0;i<size;i++){
-    dst8[i]=src8[i];
+
+static bool pool_slot_in_use(lftl_pool_t*pool, const uint8_t*base){
+  for(uint32_t i = 0; i < pool->n_areas; i++){
+    lftl_ctx_t*area = pool->areas[i];
+    if(LFTL_INVALID_POINTER == ST(area,data)) find_current_slot(area);
+    if((base == ST(area,data)) || (base == OPS(area,next_data))) return true;
   }
+  return false;
 }
-*/
-static void write_core(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size, bool transaction, bool aligned){
-  DEBUG_PRINTLN("write_core(%p,%p,%p,%u,%u,%u) entry",ctx,dst_nvm_addr,src,size,transaction,aligned);
-  //printf("src=%p, size=0x%08lx\n",src,size);
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  uintptr_t dst_nvm_addr_aligned;
-  uintptr_t addr_misalignement;
-  uintptr_t size_aligned;
-  uint64_t wu[SIZE64(write_size)];
-  memset(&wu,0x55,sizeof(wu));
-  if(aligned){
-    // check that the args are indeed aligned
-    if(0 != ((uintptr_t)dst_nvm_addr % write_size)) ctx->error_handler(LFTL_ERROR_BASE_MISALIGNED);
-    if(0 != (size % write_size)) ctx->error_handler(LFTL_ERROR_SIZE_MISALIGNED);
-    addr_misalignement = 0;
-    dst_nvm_addr_aligned = (uintptr_t)dst_nvm_addr;
-    size_aligned = size;
-  } else {
-    // unaligned: extend the start address and end address to start of WU and end of WU respectively
-    addr_misalignement = ((uintptr_t)dst_nvm_addr % write_size);
-    dst_nvm_addr_aligned = (uintptr_t)dst_nvm_addr - addr_misalignement;
-    size_aligned = size + addr_misalignement;
-    if(0 != (size_aligned % write_size)){
-      size_aligned += write_size - size_aligned % write_size;
-    }
-  }
-  const void*const current_phy_addr = translate_addr(ctx, (void*)dst_nvm_addr_aligned, size_aligned);
-  const uint8_t*const current_base = slot_base(ctx,get_current_slot_index(ctx));
-  uintptr_t offset = (uintptr_t)current_phy_addr - (uintptr_t)ctx->data;
-  const uintptr_t end_offset = offset+size_aligned;
-  const unsigned int index = next_slot(ctx);
-  uint8_t*const base = slot_base(ctx, index);
-  if(base == current_base) ctx->error_handler(LFTL_INTERNAL_ERROR);
-  void* phy_addr = base + offset;
-  const uint8_t* src_phy_addr = src;
-  lftl_ctx_t* src_ctx = is_in_any_nvm(src_phy_addr);
-  if(LFTL_INVALID_POINTER!=src_ctx){
-    if(is_in_data(src_ctx,src_phy_addr)){ // src is in an LFTL area
-      src_phy_addr = translate_addr(src_ctx, (void*)src_phy_addr, size);
-    }
-  }else{
-    src_ctx = ctx;
-  }
-  if(!transaction){
-    if(LFTL_INVALID_POINTER != ctx->transaction_tracker) ctx->error_handler(LFTL_ERROR_TRANSACTION_ONGOING);
-    //erase next slot
-    erase_slot(ctx,index);
-    //write new data in next slot
-    if(offset){
-      nvm_write(ctx, base, current_base, offset);
-    }
-  }
-  if(addr_misalignement){
-    // fix up first WU
-    uintptr_t size_consumed = write_size - addr_misalignement;
-    if(size_consumed > size){
-      const uintptr_t tail_size = size_consumed - size;
-      size_consumed = size;
-      nvm_read(ctx, ((uint8_t*)&wu) + addr_misalignement + size, current_base+offset+ addr_misalignement+size, tail_size);
+
+// Least (or most) erased slot of the pool which is neither the current 
+// slot nor the next slot of any of its areas, 0 if there is none
+static uint8_t*pool_free_slot(lftl_ctx_t*ctx, bool most_erased){
+  uint8_t*best = 0;
+  uint32_t best_count = 0;
+  const unsigned int ns = n_slots(ctx);
+  for(unsigned int i = 0; i < ns; i++){
+    uint8_t*const base = slot_base(ctx,i);
+    if(pool_slot_in_use(POOL(ctx),base)) continue;
+    const uint32_t count = pool_erase_count(ctx,base);
+    if((0 == best) || (most_erased ? count > best_count : count < best_count)){
+      best = base;
+      best_count = count;
     }
-    nvm_read(ctx, &wu, current_base+offset, addr_misalignement);
-    mem_read(src_ctx,((uint8_t*)&wu) + addr_misalignement, src_phy_addr , size_consumed);
-    nvm_write(ctx,phy_addr,&wu,write_size);
-    // adjust write range
-    offset += write_size;
-    phy_addr = base + offset;
-    src_phy_addr += size_consumed;
-    size_aligned -= write_size;
-    size -= size_consumed;
-  }
-  if(size != size_aligned){
-    //remove the last write unit from the write range as it needs special handling
-    size_aligned -= write_size;
-  }
-  //at this point size_aligned >= size
-  nvm_write(ctx,phy_addr,src_phy_addr,size_aligned);
-  if(size != size_aligned){
-    const uintptr_t last_wu_offset = offset+size_aligned;
-    // fix up last WU
-    uintptr_t size_misalignement = size % write_size;//((uintptr_t)dst_nvm_addr + size) % write_size;
-    const uintptr_t wu_part1_size = size_misalignement;
-    const uint8_t* wu_part1_src = ((uint8_t*)src_phy_addr) + size_aligned;
-    mem_read(src_ctx,&wu,wu_part1_src, wu_part1_size);
-    uint8_t*const wu_part2_base = ((uint8_t*)&wu) + size_misalignement;
-    const uintptr_t wu_part2_size = write_size - size_misalignement;
-    const uint8_t* wu_part2_src = current_base + last_wu_offset + size_misalignement;
-    nvm_read(ctx, wu_part2_base, wu_part2_src, wu_part2_size);
-    nvm_write(ctx, base+last_wu_offset, &wu, write_size);
   }
-  if(!transaction){
-    const uintptr_t remaining = ctx->data_size - end_offset;
-    if(remaining){
-      nvm_write(ctx, base+end_offset, current_base + end_offset, remaining);
-    }
-    //increment version and write new meta data in next slot
-    const uint32_t version = 1 + get_slot_version(ctx, get_current_slot_index(ctx));
-    write_meta(ctx, index, version);
-    //update context
-    ctx->data = base;
+  return best;
+}
+
+// The next slot of a pooled area is reserved until its meta data is written
+static uint8_t*next_slot_base(lftl_ctx_t*ctx){
+  if(0 == POOL(ctx)) return slot_base(ctx, next_slot(ctx));
+  if(0 == OPS(ctx,next_data)){
+    OPS(ctx,next_data) = pool_free_slot(ctx,false);
+    if(0 == OPS(ctx,next_data)) CFG(ctx)->error_handler(LFTL_ERROR_POOL_FULL);
   }
-  DEBUG_PRINTLN("write_core exit");
+  return OPS(ctx,next_data);
+}
+static void check_idle(lftl_ctx_t*ctx){
+  if(CFG(ctx)->async && CFG(ctx)->async->job.steps) CFG(ctx)->error_handler(LFTL_ERROR_ASYNC_ONGOING);
+  if(OPS(ctx,stream)) CFG(ctx)->error_handler(LFTL_ERROR_STREAM_ONGOING);
 }
 
-static void erase(lftl_ctx_t*ctx, void*const dst_nvm_addr, uintptr_t size){
-  DEBUG_PRINTLN("erase entry");
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  if(0 != ((uintptr_t)dst_nvm_addr % write_size)) ctx->error_handler(LFTL_ERROR_BASE_MISALIGNED);
-  if(0 != (size % write_size)) ctx->error_handler(LFTL_ERROR_SIZE_MISALIGNED);
-  const void*const current_phy_addr = translate_addr(ctx, dst_nvm_addr, size);
-  const uint8_t*const current_base = slot_base(ctx,get_current_slot_index(ctx));
-  const uintptr_t offset = (uintptr_t)current_phy_addr - (uintptr_t)ctx->data;
-  const unsigned int index = next_slot(ctx);
-  uint8_t*const base = slot_base(ctx, index);
-
-  if(LFTL_INVALID_POINTER != ctx->transaction_tracker) ctx->error_handler(LFTL_ERROR_TRANSACTION_ONGOING);
-  //erase next slot
-  erase_slot(ctx,index);
-  //write new data in next slot
-  if(offset){
-    nvm_write(ctx, base, current_base, offset);
-  }
-
-  const uintptr_t end_offset = offset+size;
-  const uintptr_t remaining = ctx->data_size - end_offset;
-  if(remaining){
-    nvm_write(ctx, base+end_offset, current_base + end_offset, remaining);
-  }
-  //increment version and write new meta data in next slot
-  const uint32_t version = 1 + get_slot_version(ctx, get_current_slot_index(ctx));
-  write_meta(ctx, index, version);
-  //update context
-  ctx->data = base;
-  DEBUG_PRINTLN("erase exit");
+static void accessor_start_erase(lftl_ctx_t*ctx, void*base_address, unsigned int n_pages){
+  STATS_ADD(ctx,erase_calls,1);
+  STATS_ADD(ctx,erased_pages,n_pages);
+  TRACE_START(ctx,"start_erase",base_address,n_pages);
+  uint8_t status = CFG(ctx)->async->start_erase(base_address, n_pages);
+  TRACE_END(ctx,"start_erase");
+  if(status) {
+    CFG(ctx)->async->job.steps = 0;
+    CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_ERASE | status);
+  }
 }
 
-#define xstr(s) str(s)
-#define str(s) #s
-static const char*version = xstr(GIT_VERSION);
-static const uint64_t version_timestamp = VERSION_TIMESTAMP;
-static const char*build_type = xstr(BUILD_TYPE);
+static void accessor_start_write(lftl_ctx_t*ctx, void*dst_nvm_addr, const void*const src, uintptr_t size){
+  STATS_ADD(ctx,write_calls,1);
+  STATS_ADD(ctx,programmed_bytes,size);
+  TRACE_START(ctx,"start_write",dst_nvm_addr,size);
+  uint8_t status = CFG(ctx)->async->start_write(dst_nvm_addr, src, size);
+  TRACE_END(ctx,"start_write");
+  if(status) {
+    CFG(ctx)->async->job.steps = 0;
+    CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_WRITE | status);
+  }
+}
 
-const char* lftl_version(){
-  return version;
+static void accessor_start_copy(lftl_ctx_t*ctx, void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size){
+  STATS_ADD(ctx,copy_calls,1);
+  STATS_ADD(ctx,programmed_bytes,size);
+  TRACE_START(ctx,"start_copy",dst_nvm_addr,size);
+  uint8_t status = CFG(ctx)->async->start_copy(dst_nvm_addr, src_nvm_addr, size);
+  TRACE_END(ctx,"start_copy");
+  if(status) {
+    CFG(ctx)->async->job.steps = 0;
+    CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_COPY | status);
+  }
 }
 
-uint64_t lftl_version_timestamp(){
-  return version_timestamp;
+static void job_erase(lftl_ctx_t*ctx, bool async, void*base_address, unsigned int n_pages){
+  if(async) accessor_start_erase(ctx,base_address,n_pages);
+  else accessor_erase(ctx,base_address,n_pages);
 }
 
-const char* lftl_build_type(){
-  return build_type;
+static void job_write(lftl_ctx_t*ctx, bool async, void*dst_nvm_addr, const void*const src, uintptr_t size){
+  if(async) accessor_start_write(ctx,dst_nvm_addr,src,size);
+  else accessor_write(ctx,dst_nvm_addr,src,size);
 }
 
-void lftl_init_lib(){
-  has_several_nvms = 0;
-  first_area = LFTL_INVALID_POINTER;
-  last_area = LFTL_INVALID_POINTER;
+static bool is_erased(lftl_ctx_t*ctx, const uint8_t*buf, uintptr_t size){
+  for(uintptr_t i = 0; i < size; i++){
+    if(buf[i] != CFG(ctx)->nvm_props->erased_value) return false;
+  }
+  return true;
 }
 
-void lftl_register_area(lftl_ctx_t*ctx){
-  if(LFTL_INVALID_POINTER==first_area){
-    first_area = ctx;
-  } else {
-    last_area->next = ctx;
-    if(ctx->nvm_props!=first_area->nvm_props) has_several_nvms = 1;
+// compare whole words rather than bytes, memcpy compiles to plain loads
+KERNEL bool wu_is_erased_kernel(uint32_t write_size, const uint8_t*wu, uint8_t erased_value){
+  if(sizeof(uint16_t) == write_size){
+    uint16_t w;
+    memcpy(&w,wu,sizeof(w));
+    return (uint16_t)(erased_value * 0x0101u) == w;
+  }
+  const uint32_t pattern = erased_value * 0x01010101u;
+  const uint32_t words_size = write_size - write_size % sizeof(uint32_t);
+  uint32_t i = 0;
+  for(; i < words_size; i += sizeof(uint32_t)){
+    uint32_t w;
+    memcpy(&w,wu + i,sizeof(w));
+    if(pattern != w) return false;
   }
-  last_area = ctx;
-  ctx->next = first_area;
+  //write sizes which are not a multiple of 4 end with single bytes
+  for(; i < write_size; i++){
+    if(erased_value != wu[i]) return false;
+  }
+  return true;
 }
 
-void lftl_format(lftl_ctx_t*ctx){
-  DEBUG_PRINTLN("lftl_format entry");
-  if(ctx->nvm_props->write_size>LFTL_WU_MAX_SIZE) ctx->error_handler(LFTL_ERROR_WU_SIZE_TOO_LARGE);
-  nvm_erase(ctx,ctx->area,n_pages(ctx));
-  ctx->data = ctx->area;
-  write_meta(ctx, 0, 1);
-  DEBUG_PRINTLN("lftl_format exit");
+static bool wu_is_erased(lftl_ctx_t*ctx, const uint8_t*wu){
+  return WU_KERNEL(WRITE_SIZE(ctx),wu_is_erased_kernel,wu,CFG(ctx)->nvm_props->erased_value);
 }
 
-lftl_ctx_t*lftl_get_ctx(const void*const addr){
-  lftl_ctx_t*ctx = first_area;
-  if(is_in_data(ctx,addr)) return ctx;
-  return get_other_ctx(ctx,addr);
+// src is read by chunks of several write units
+KERNEL uintptr_t erased_run_kernel(uint32_t write_size, lftl_ctx_t*ctx, lftl_ctx_t*src_ctx, const uint8_t*src, uintptr_t size, bool erased){
+  uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+  const uint8_t erased_value = CFG(ctx)->nvm_props->erased_value;
+  uintptr_t run = 0;
+  while(run < size){
+    uintptr_t chunk = size - run;
+    if(chunk > sizeof(buf)) chunk = sizeof(buf) - sizeof(buf) % write_size;
+    mem_read(src_ctx,buf,src + run,chunk);
+    for(uintptr_t i = 0; i < chunk; i += write_size){
+      if(wu_is_erased_kernel(write_size,(const uint8_t*)buf + i,erased_value) != erased) return run + i;
+    }
+    run += chunk;
+  }
+  return run;
 }
 
-void lftl_erase_all(lftl_ctx_t*ctx){
-  erase(ctx, ctx->area, ctx->data_size);//dst_nvm_addr is area because erase function does the address translation
+// Size of the leading write units of src which are erased (or not erased), up to size
+static uintptr_t erased_run(lftl_ctx_t*ctx, lftl_ctx_t*src_ctx, const uint8_t*src, uintptr_t size, bool erased){
+  return WU_KERNEL(WRITE_SIZE(ctx),erased_run_kernel,ctx,src_ctx,src,size,erased);
 }
 
-void lftl_basic_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
-  if(0==size) return;
-  write_core(ctx,dst_nvm_addr,src,size,NO_TRANSACTION,UNALIGNED);
+// Write a range of the next slot, issue at most one NVM operation.
+// Returns true when the whole range is written, false if it shall be called again.
+static bool job_range(lftl_ctx_t*ctx, lftl_job_t*job, bool async, lftl_ctx_t*src_ctx, uint8_t*dst_nvm_addr, const uint8_t*src, uintptr_t size){
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const bool src_in_nvm = is_in_nvm(src_ctx,src);
+  bool use_copy = false;
+  if(src_in_nvm && (CFG(src_ctx)->nvm_props == CFG(ctx)->nvm_props) && (0 == (uintptr_t)src % write_size)){
+    use_copy = async ? 0 != CFG(ctx)->async->start_copy : 0 != CFG(ctx)->copy;
+  }
+  const bool use_buffer = src_in_nvm && !use_copy && CFG(ctx)->copy_buffer && (CFG(ctx)->copy_buffer_size >= write_size);
+  const uintptr_t chunk_max = use_buffer ? CFG(ctx)->copy_buffer_size - CFG(ctx)->copy_buffer_size % write_size : size;
+  uintptr_t start = job->copied;
+  if(CFG(ctx)->nvm_props->skip_erased){
+    //the next slot is erased: no need to program erased write units
+    start += erased_run(ctx,src_ctx,src + start,size - start,true);
+  }
+  uintptr_t len = size - start;
+  if(len > chunk_max) len = chunk_max;
+  if(CFG(ctx)->nvm_props->skip_erased){
+    len = erased_run(ctx,src_ctx,src + start,len,false);
+  }
+  if(len){
+    if(use_copy){
+      if(async) accessor_start_copy(ctx,dst_nvm_addr + start,src + start,len);
+      else accessor_copy(ctx,dst_nvm_addr + start,src + start,len);
+    } else if(use_buffer){
+      //read + write through the bounce buffer
+      accessor_read(src_ctx,CFG(ctx)->copy_buffer,src + start,len);
+      job_write(ctx,async,dst_nvm_addr + start,CFG(ctx)->copy_buffer,len);
+    } else {
+      job_write(ctx,async,dst_nvm_addr + start,src + start,len);
+    }
+  }
+  job->copied = start + len;
+  if(job->copied < size) return false;
+  job->copied = 0;
+  return true;
 }
 
-void lftl_read(lftl_ctx_t*ctx, void*dst, const void*const src_nvm_addr, uintptr_t size){
-  DEBUG_PRINTLN("lftl_read entry");
-  if(0==size) return;
-  const void*const phy_addr = translate_addr(ctx, src_nvm_addr, size);
-  nvm_read(ctx,dst, phy_addr, size);
-  DEBUG_PRINTLN("lftl_read exit");
+static void job_write_wu(lftl_ctx_t*ctx, bool async, void*dst_nvm_addr, const uint8_t*wu){
+  if(CFG(ctx)->nvm_props->skip_erased && wu_is_erased(ctx,wu)) return;
+  job_write(ctx,async,dst_nvm_addr,wu,WRITE_SIZE(ctx));
 }
 
-void lftl_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker){
-  if(LFTL_INVALID_POINTER != ctx->transaction_tracker) ctx->error_handler(LFTL_ERROR_TRANSACTION_ONGOING);
-  ctx->transaction_tracker = transaction_tracker;
-  const uint32_t size = LFTL_TRANSACTION_TRACKER_SIZE(ctx);
-  memset(ctx->transaction_tracker,0,size);
-  const unsigned int index = next_slot(ctx);
-  //erase next slot
-  erase_slot(ctx,index);
+// Compact tracker: number of ranges, max number of ranges, then sorted 
+// [start,end[ ranges of write units. Ranges are disjoint and not adjacent.
+#define COMPACT_N_RANGES 0
+#define COMPACT_MAX_RANGES 1
+#define COMPACT_RANGES 2
+
+static uint32_t*compact_ranges(lftl_ctx_t*ctx){
+  return (uint32_t*)OPS(ctx,transaction_tracker) + COMPACT_RANGES;
 }
 
-void lftl_transaction_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
-  if(LFTL_INVALID_POINTER == ctx->transaction_tracker) ctx->error_handler(LFTL_ERROR_NO_TRANSACTION);
-  //check/update transaction tracker
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  const uint32_t n_write_units = size / write_size;
-  const uintptr_t offset = (uintptr_t)dst_nvm_addr - (uintptr_t)ctx->area;
-  const uint32_t offset_wu = offset / write_size;
-  uint8_t*tracker = (uint8_t*)ctx->transaction_tracker;
-  for(uintptr_t i = 0; i < n_write_units; i++){
-    const uint32_t wu_index = offset_wu+i;
-    const uint32_t byte_index = wu_index / BITS_PER_BYTE;
-    const uint32_t bit_index = wu_index % BITS_PER_BYTE;
-    const uint8_t mask = 1 << bit_index;
-    if(tracker[byte_index] & mask) ctx->error_handler(LFTL_ERROR_TRANSACTION_OVERWRITE);
-    tracker[byte_index] |= mask;
+// index of the first range ending after wu_index
+static uint32_t compact_search(lftl_ctx_t*ctx, uint32_t wu_index){
+  const uint32_t*ranges = compact_ranges(ctx);
+  uint32_t lo = 0;
+  uint32_t hi = ((uint32_t*)OPS(ctx,transaction_tracker))[COMPACT_N_RANGES];
+  while(lo < hi){
+    const uint32_t mid = (lo + hi) / 2;
+    if(ranges[2*mid+1] <= wu_index) lo = mid + 1;
+    else hi = mid;
   }
-  write_core(ctx,dst_nvm_addr,src,size,TRANSACTION, ALIGNED);
+  return lo;
 }
 
-void lftl_transaction_write_any(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  const uintptr_t addr_misalignement = ((uintptr_t)dst_nvm_addr % write_size);
-  const bool addr_is_aligned = 0 == addr_misalignement;
-  const bool size_is_aligned = 0 == (size % write_size);
-  if(addr_is_aligned & size_is_aligned) {
-    lftl_transaction_write(ctx, dst_nvm_addr, src, size);
+static void compact_set(lftl_ctx_t*ctx, uint32_t start, uint32_t n_write_units){
+  uint32_t*tracker = (uint32_t*)OPS(ctx,transaction_tracker);
+  uint32_t*ranges = compact_ranges(ctx);
+  const uint32_t n = tracker[COMPACT_N_RANGES];
+  const uint32_t end = start + n_write_units;
+  const uint32_t i = compact_search(ctx,start);
+  if((i < n) && (ranges[2*i] < end)) CFG(ctx)->error_handler(LFTL_ERROR_TRANSACTION_OVERWRITE);
+  const bool merge_prev = (i > 0) && (ranges[2*(i-1)+1] == start);
+  const bool merge_next = (i < n) && (ranges[2*i] == end);
+  if(merge_prev && merge_next){
+    ranges[2*(i-1)+1] = ranges[2*i+1];
+    memmove(ranges+2*i,ranges+2*(i+1),(n-i-1)*2*sizeof(uint32_t));
+    tracker[COMPACT_N_RANGES] = n - 1;
+  } else if(merge_prev){
+    ranges[2*(i-1)+1] = end;
+  } else if(merge_next){
+    ranges[2*i] = start;
   } else {
-    if(LFTL_INVALID_POINTER == ctx->transaction_tracker) ctx->error_handler(LFTL_ERROR_NO_TRANSACTION);
-    //check/update transaction tracker
-    const uintptr_t dst_nvm_addr_aligned = (uintptr_t)dst_nvm_addr - addr_misalignement;
-    const uint32_t n_write_units = LFTL_DIV_CEIL(size+addr_misalignement,write_size);
-    const uintptr_t offset = dst_nvm_addr_aligned - (uintptr_t)ctx->area;
-    const uint32_t offset_wu = offset / write_size;
-    uint8_t*tracker = (uint8_t*)ctx->transaction_tracker;
-    for(uintptr_t i = 0; i < n_write_units; i++){
-      const uint32_t wu_index = offset_wu+i;
-      const uint32_t byte_index = wu_index / BITS_PER_BYTE;
-      const uint32_t bit_index = wu_index % BITS_PER_BYTE;
-      const uint8_t mask = 1 << bit_index;
-      if(tracker[byte_index] & mask) ctx->error_handler(LFTL_ERROR_TRANSACTION_OVERWRITE);
-      tracker[byte_index] |= mask;
-    }
-    write_core(ctx,dst_nvm_addr,src,size,TRANSACTION, UNALIGNED);
+    if(n == tracker[COMPACT_MAX_RANGES]) CFG(ctx)->error_handler(LFTL_ERROR_TRACKER_FULL);
+    memmove(ranges+2*(i+1),ranges+2*i,(n-i)*2*sizeof(uint32_t));
+    ranges[2*i] = start;
+    ranges[2*i+1] = end;
+    tracker[COMPACT_N_RANGES] = n + 1;
   }
-  
 }
 
-void lftl_transaction_commit(lftl_ctx_t*ctx){
-  if(LFTL_INVALID_POINTER == ctx->transaction_tracker) ctx->error_handler(LFTL_ERROR_NO_TRANSACTION);
-  //lookup transaction tracker and copy unwritten write units
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  const uint32_t n_write_units = ctx->data_size / write_size;
-  uintptr_t nvm_addr = (uintptr_t)ctx->area;
-  uint8_t*tracker = (uint8_t*)ctx->transaction_tracker;
-  uint32_t wu_cnt=0;
-  for(uintptr_t i = 0; i < LFTL_DIV_CEIL(n_write_units,BITS_PER_BYTE); i++){
-    const uint8_t track_byte = tracker[i];
-    uint8_t mask = 1;
-    for(unsigned int bi = 0; bi < BITS_PER_BYTE; bi++){
-      if(0 == (track_byte & mask)){
-        uint64_t buf[SIZE64(write_size)];
-        lftl_read(ctx,buf,(void*)nvm_addr,write_size);
-        write_core(ctx,(void*)nvm_addr,buf,write_size,TRANSACTION,ALIGNED);//TODO: optimize, at least by doing address translation once and calling nvm_write directly.
-      }
-      mask = mask << 1;
-      nvm_addr += write_size;
-      wu_cnt++;
-      if(wu_cnt == n_write_units) break;
-    }
+static void tracker_init(lftl_ctx_t*ctx, void *const transaction_tracker, uintptr_t compact_size){
+  OPS(ctx,transaction_tracker) = transaction_tracker;
+  OPS(ctx,compact_tracker) = 0 != compact_size;
+  if(OPS(ctx,compact_tracker)){
+    uint32_t*tracker = (uint32_t*)transaction_tracker;
+    tracker[COMPACT_N_RANGES] = 0;
+    const uint32_t n_items = compact_size / (2*sizeof(uint32_t));
+    tracker[COMPACT_MAX_RANGES] = n_items - 1;
+  } else {
+    memset(transaction_tracker,0,LFTL_TRANSACTION_TRACKER_SIZE_LL(DATA_SIZE(ctx),WRITE_SIZE(ctx)));
   }
-  //increment version and write new meta data in next slot
-  const unsigned int index = next_slot(ctx);
-  uint8_t*const base = slot_base(ctx, index);
-  const uint32_t version = 1 + get_slot_version(ctx, get_current_slot_index(ctx));
-  write_meta(ctx, index, version);
-  //update context
-  ctx->data = base;
-  ctx->transaction_tracker = LFTL_INVALID_POINTER;
 }
 
-void lftl_transaction_abort(lftl_ctx_t*ctx){
-  ctx->transaction_tracker = LFTL_INVALID_POINTER;
+static bool tracker_is_set(lftl_ctx_t*ctx, uint32_t wu_index){
+  if(OPS(ctx,compact_tracker)){
+    const uint32_t i = compact_search(ctx,wu_index);
+    if(i == ((uint32_t*)OPS(ctx,transaction_tracker))[COMPACT_N_RANGES]) return false;
+    return compact_ranges(ctx)[2*i] <= wu_index;
+  }
+  const uint8_t*tracker = (const uint8_t*)OPS(ctx,transaction_tracker);
+  const uint32_t byte_index = wu_index / BITS_PER_BYTE;
+  const uint32_t bit_index = wu_index % BITS_PER_BYTE;
+  return tracker[byte_index] & (1 << bit_index);
 }
 
-void lftl_transaction_read(lftl_ctx_t*ctx, void*dst, const void*const src_nvm_addr, uintptr_t size){
-  if(LFTL_INVALID_POINTER == ctx->transaction_tracker) ctx->error_handler(LFTL_ERROR_NO_TRANSACTION);
-  if(0==size) return;
-  const uint32_t write_size = ctx->nvm_props->write_size;
-  const uint32_t n_write_units = size / write_size;
-  const uintptr_t offset = (uintptr_t)src_nvm_addr - (uintptr_t)ctx->area;
-  const uint32_t offset_wu = offset / write_size;
-  uint8_t*tracker = (uint8_t*)ctx->transaction_tracker;
-  const unsigned int index = next_slot(ctx);
-  uint8_t*const base = slot_base(ctx, index);
-  uint8_t*dst8 = (uint8_t*)dst;
-  for(uintptr_t i = 0; i < n_write_units; i++){
-    const uint32_t wu_index = offset_wu+i;
-    const uint32_t byte_index = wu_index / BITS_PER_BYTE;
+// bitmap tracker: the bits of a byte are checked and set together
+KERNEL void tracker_set_kernel(uint32_t write_size, lftl_ctx_t*ctx, uintptr_t offset, uint32_t n_write_units){
+  uint8_t*tracker = (uint8_t*)OPS(ctx,transaction_tracker);
+  uint32_t wu_index = offset / write_size;
+  const uint32_t end = wu_index + n_write_units;
+  while(wu_index < end){
     const uint32_t bit_index = wu_index % BITS_PER_BYTE;
-    const uint8_t mask = 1 << bit_index;
-    if(tracker[byte_index] & mask) {
-      //read new data
-      void*phy_addr = base + wu_index*write_size;
-      nvm_read(ctx,dst8, phy_addr, write_size);
-    }else{
-      //read current data
-      void*phy_addr = (uint8_t*)(ctx->data) + wu_index*write_size;
-      nvm_read(ctx,dst8, phy_addr, write_size);
-    }
-    dst8 += write_size;
+    uint32_t n_bits = BITS_PER_BYTE - bit_index;
+    if(n_bits > end - wu_index) n_bits = end - wu_index;
+    const uint8_t mask = (uint8_t)(((1u << n_bits) - 1) << bit_index);
+    uint8_t*const byte = tracker + wu_index / BITS_PER_BYTE;
+    if(*byte & mask) CFG(ctx)->error_handler(LFTL_ERROR_TRANSACTION_OVERWRITE);
+    *byte |= mask;
+    wu_index += n_bits;
   }
 }
 
-void lftl_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
-  if(0==size) return;
-  if(ctx->transaction_tracker == LFTL_INVALID_POINTER){
-    lftl_basic_write(ctx, dst_nvm_addr, src, size);
-  } else {
-    lftl_transaction_write(ctx, dst_nvm_addr, src, size);
+static void tracker_set(lftl_ctx_t*ctx, const void*const dst_nvm_addr_aligned, uint32_t n_write_units){
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uintptr_t offset = (uintptr_t)dst_nvm_addr_aligned - (uintptr_t)CFG(ctx)->area;
+  if(OPS(ctx,compact_tracker)){
+    if(n_write_units) compact_set(ctx,offset / write_size,n_write_units);
+    return;
   }
+  WU_KERNEL(write_size,tracker_set_kernel,ctx,offset,n_write_units);
 }
 
-void lftl_write_any(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
-  if(0==size) return;
-  if(ctx->transaction_tracker == LFTL_INVALID_POINTER){
-    lftl_basic_write(ctx, dst_nvm_addr, src, size);
-  } else {
-    lftl_transaction_write_any(ctx, dst_nvm_addr, src, size);
+// find the next range of write units not written during the transaction, starting at *wu_index
+static bool tracker_next_gap(lftl_ctx_t*ctx, uint32_t*wu_index, uint32_t*n_wu){
+  const uint32_t n_write_units = DATA_SIZE(ctx) / WRITE_SIZE(ctx);
+  uint32_t start = *wu_index;
+  if(OPS(ctx,compact_tracker)){
+    const uint32_t*ranges = compact_ranges(ctx);
+    const uint32_t n = ((uint32_t*)OPS(ctx,transaction_tracker))[COMPACT_N_RANGES];
+    uint32_t i = compact_search(ctx,start);
+    if((i < n) && (ranges[2*i] <= start)) start = ranges[2*(i++)+1];
+    if(start >= n_write_units) return false;
+    const uint32_t end = i < n ? ranges[2*i] : n_write_units;
+    *wu_index = start;
+    *n_wu = end - start;
+    return true;
+  }
+  //whole bytes of the bitmap are skipped, bits beyond the data are never set
+  const uint8_t*tracker = (const uint8_t*)OPS(ctx,transaction_tracker);
+  while(start < n_write_units){
+    if((0 == start % BITS_PER_BYTE) && (0xFF == tracker[start / BITS_PER_BYTE])) start += BITS_PER_BYTE;
+    else if(tracker_is_set(ctx,start)) start++;
+    else break;
+  }
+  if(start >= n_write_units) return false;
+  uint32_t end = start + 1;
+  while(end < n_write_units){
+    if((0 == end % BITS_PER_BYTE) && (0 == tracker[end / BITS_PER_BYTE])) end += BITS_PER_BYTE;
+    else if(!tracker_is_set(ctx,end)) end++;
+    else break;
   }
+  if(end > n_write_units) end = n_write_units;
+  *wu_index = start;
+  *n_wu = end - start;
+  return true;
 }
 
-void lftl_read_newer(lftl_ctx_t*ctx, void*dst, const void*const src_nvm_addr, uintptr_t size){
-  if(0==size) return;
-  DEBUG_PRINTLN("lftl_read_newer entry");
-  if(ctx->transaction_tracker == LFTL_INVALID_POINTER){
-    lftl_read(ctx, dst, src_nvm_addr, size);
-  } else {
-    lftl_transaction_read(ctx, dst, src_nvm_addr, size);
-  }
+#define OVERLAY_FREE 0xFFFFFFFF
+
+static uint32_t*overlay_entry(lftl_ctx_t*ctx, uint32_t i){
+  const uintptr_t entry_size = LFTL_OVERLAY_ENTRY_SIZE_LL(WRITE_SIZE(ctx));
+  return (uint32_t*)((uint8_t*)OPS(ctx,overlay)->entries + i*entry_size);
+}
+
+static uint32_t overlay_home(lftl_ctx_t*ctx, uint32_t wu_index){
+  return (wu_index * 2654435761u) % OPS(ctx,overlay)->n_entries;
+}
+
+// find the entry caching wu_index, returns 0 if not found
+static const uint32_t*overlay_find(lftl_ctx_t*ctx, uint32_t wu_index){
+  if(0 == OPS(ctx,overlay)) return 0;
+  const uint32_t n = OPS(ctx,overlay)->n_entries;
+  uint32_t i = overlay_home(ctx,wu_index);
+  for(uint32_t k = 0; k < n; k++){
+    const uint32_t*entry = overlay_entry(ctx,i);
+    if(wu_index == entry[0]) return entry;
+    if(OVERLAY_FREE == entry[0]) return 0;
+    i = (i + 1) % n;
+  }
+  return 0;
+}
+
+// program a cached write unit in the next slot
+static void overlay_program(lftl_ctx_t*ctx, uint32_t*entry){
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uintptr_t offset = entry[0] * write_size;
+  tracker_set(ctx,(uint8_t*)CFG(ctx)->area + offset,1);
+  job_write_wu(ctx,false,next_slot_base(ctx) + offset,(const uint8_t*)(entry+1));
+  entry[0] = OVERLAY_FREE;
+}
+
+// get the entry caching wu_index, allocate it if needed
+static uint32_t*overlay_get(lftl_ctx_t*ctx, uint32_t wu_index){
+  const uint32_t n = OPS(ctx,overlay)->n_entries;
+  const uint32_t home = overlay_home(ctx,wu_index);
+  uint32_t i = home;
+  uint32_t*entry = 0;
+  for(uint32_t k = 0; k < n; k++){
+    entry = overlay_entry(ctx,i);
+    if(wu_index == entry[0]) return entry;
+    if(OVERLAY_FREE == entry[0]) break;
+    i = (i + 1) % n;
+  }
+  if(tracker_is_set(ctx,wu_index)) CFG(ctx)->error_handler(LFTL_ERROR_TRANSACTION_OVERWRITE);
+  if(OVERLAY_FREE != entry[0]){
+    //overlay is full, evict the entry at home position
+    entry = overlay_entry(ctx,home);
+    overlay_program(ctx,entry);
+  }
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  entry[0] = wu_index;
+  accessor_read(ctx,entry+1,(const uint8_t*)ST(ctx,data) + wu_index * write_size,write_size);
+  return entry;
+}
+
+// program all cached write units
+static void overlay_flush(lftl_ctx_t*ctx){
+  if(0 == OPS(ctx,overlay)) return;
+  for(uint32_t i = 0; i < OPS(ctx,overlay)->n_entries; i++){
+    uint32_t*entry = overlay_entry(ctx,i);
+    if(OVERLAY_FREE != entry[0]) overlay_program(ctx,entry);
+  }
+}
+
+// Steps of a job
+#define JOB_ERASE           0x01 // erase the next slot
+#define JOB_COPY            0x02 // copy current data before and after the written range
+#define JOB_BODY            0x04 // write the source data
+#define JOB_GAPS            0x08 // copy current data not written during the transaction
+#define JOB_META            0x10 // write meta data and switch to the next slot
+#define JOB_END_TRANSACTION 0x20 // release the transaction tracker
+#define JOB_CRC             0x40 // checksum of the data is provided in crc
+#define JOB_PENDING         0x80 // mark the new version as pending, see group API
+
+// Phases of a job, each phase issues at most one NVM erase or write
+enum {
+  PHASE_ERASE = 0,
+  PHASE_POOL,
+  PHASE_HEAD,
+  PHASE_FIRST_WU,
+  PHASE_BODY,
+  PHASE_LAST_WU,
+  PHASE_TAIL,
+  PHASE_GAPS,
+  PHASE_META,
+  PHASE_CHECKSUM2,
+  PHASE_DONE
+};
+
+static void init_job(lftl_ctx_t*ctx, lftl_job_t*job, uint8_t steps){
+  job->steps = steps;
+  job->phase = PHASE_ERASE;
+  job->base = next_slot_base(ctx);
+  if(job->base == ST(ctx,data)) CFG(ctx)->error_handler(LFTL_INTERNAL_ERROR);
+  job->head_size = 0;
+  job->end_offset = DATA_SIZE(ctx);
+  job->offset = 0;
+  job->misalignment = 0;
+  job->src = 0;
+  job->size = 0;
+  job->src_ctx = ctx;
+  job->wu_index = 0;
+  job->copied = 0;
+}
+
+// Issue the next NVM operation of a job.
+// Returns true when the job is completed.
+static bool job_step(lftl_ctx_t*ctx, lftl_job_t*job, bool async){
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uint8_t*const current_base = (const uint8_t*)ST(ctx,data);
+  uint8_t*const base = job->base;
+  uint8_t*const wu = (uint8_t*)job->wu;
+  while(1){
+    switch(job->phase++){
+    case PHASE_ERASE:
+      if(job->steps & JOB_ERASE){
+        if(POOL(ctx)) job->erase_count = 1 + pool_erase_count(ctx,base);
+        job_erase(ctx,async,base,n_pages_in_slot(ctx));
+        return false;
+      }
+      break;
+    case PHASE_POOL:
+      if((job->steps & JOB_ERASE) && POOL(ctx)){
+        //write the pool items right away: the erase count is kept even if the slot is never completed
+        lftl_meta_t meta;
+        meta.owner = pool_owner(ctx);
+        meta.erase_count = job->erase_count;
+        pack_pool_meta(ctx,job->meta,&meta);
+        job_write(ctx,async,base + meta_offset(ctx),job->meta,pool_meta_size(ctx));
+        return false;
+      }
+      break;
+    case PHASE_HEAD:
+      if((job->steps & JOB_COPY) && job->head_size){
+        if(!job_range(ctx,job,async,ctx,base,current_base,job->head_size)) job->phase = PHASE_HEAD;
+        return false;
+      }
+      break;
+    case PHASE_FIRST_WU:
+      if((job->steps & JOB_BODY) && job->misalignment){
+        // fix up first WU
+        const uintptr_t misalignment = job->misalignment;
+        uintptr_t size_consumed = write_size - misalignment;
+        if(size_consumed > job->size){
+          const uintptr_t tail_size = size_consumed - job->size;
+          size_consumed = job->size;
+          accessor_read(ctx, wu + misalignment + job->size, current_base + job->offset + misalignment + job->size, tail_size);
+        }
+        accessor_read(ctx, wu, current_base + job->offset, misalignment);
+        mem_read(job->src_ctx, wu + misalignment, job->src, size_consumed);
+        job_write_wu(ctx,async,base + job->offset,wu);
+        // adjust write range
+        job->offset += write_size;
+        job->src += size_consumed;
+        job->size -= size_consumed;
+        return false;
+      }
+      break;
+    case PHASE_BODY:
+      if(job->steps & JOB_BODY){
+        const uintptr_t body_size = job->size - job->size % write_size;
+        if(body_size){
+          if(!job_range(ctx,job,async,job->src_ctx,base + job->offset,job->src,body_size)){
+            job->phase = PHASE_BODY;
+            return false;
+          }
+          job->offset += body_size;
+          job->src += body_size;
+          job->size -= body_size;
+          return false;
+        }
+      }
+      break;
+    case PHASE_LAST_WU:
+      if((job->steps & JOB_BODY) && job->size){
+        // fix up last WU
+        const uintptr_t size_misalignement = job->size;
+        mem_read(job->src_ctx, wu, job->src, size_misalignement);
+        accessor_read(ctx, wu + size_misalignement, current_base + job->offset + size_misalignement, write_size - size_misalignement);
+        job_write_wu(ctx,async,base + job->offset,wu);
+        job->offset += write_size;
+        job->src += size_misalignement;
+        job->size = 0;
+        return false;
+      }
+      break;
+    case PHASE_TAIL:
+      if(job->steps & JOB_COPY){
+        const uintptr_t remaining = DATA_SIZE(ctx) - job->end_offset;
+        if(remaining){
+          if(!job_range(ctx,job,async,ctx,base + job->end_offset,current_base + job->end_offset,remaining)) job->phase = PHASE_TAIL;
+          return false;
+        }
+      }
+      break;
+    case PHASE_GAPS:
+      if(job->steps & JOB_GAPS){
+        uint32_t n_wu;
+        if(tracker_next_gap(ctx,&job->wu_index,&n_wu)){
+          const uintptr_t offset = job->wu_index * write_size;
+          if(job_range(ctx,job,async,ctx,base + offset,current_base + offset,n_wu * write_size)) job->wu_index += n_wu;
+          job->phase = PHASE_GAPS;
+          return false;
+        }
+      }
+      break;
+    case PHASE_META:
+      if(job->steps & JOB_META){
+        //increment version and write new meta data in next slot
+        lftl_meta_t meta;
+        get_meta_at(ctx,&meta,base);
+        meta.version = 1 + version_number(get_slot_version(ctx, get_current_slot_index(ctx)));
+        if(job->steps & JOB_PENDING) meta.version |= VERSION_PENDING;
+        const uint32_t crc = (job->steps & JOB_CRC) ? job->crc : checksum(ctx,base,DATA_SIZE(ctx));
+        meta.checksum = meta_checksum(ctx,crc,&meta);
+        meta.checksum2 = meta.checksum;
+        pack_meta(ctx,job->meta,&meta);
+        //write everything but checksum2
+        const unsigned int item_size = meta_item_size(ctx);
+        job_write(ctx,async,base + meta_offset(ctx) + pool_meta_size(ctx),job->meta,(LFTL_META_N_ITEMS-1) * item_size);
+        return false;
+      }
+      break;
+    case PHASE_CHECKSUM2:
+      if(job->steps & JOB_META){
+        const unsigned int item_size = meta_item_size(ctx);
+        const uintptr_t checksum2_offset = (LFTL_META_N_ITEMS-1) * item_size;
+        job_write(ctx,async,base + meta_offset(ctx) + pool_meta_size(ctx) + checksum2_offset,((uint8_t*)job->meta) + checksum2_offset,item_size);
+        return false;
+      }
+      break;
+    default:
+      //update context
+      if(job->steps & JOB_META) {
+        set_data(ctx, base);
+        OPS(ctx,next_data) = 0;
+        PROFILE_UPDATE(ctx);
+      }
+      if(job->steps & JOB_END_TRANSACTION) {
+        OPS(ctx,transaction_tracker) = LFTL_INVALID_POINTER;
+        OPS(ctx,overlay) = 0;
+      }
+      job->steps = 0;
+      return true;
+    }
+  }
+}
+
+static bool is_idle(lftl_ctx_t*ctx){
+  if(CFG(ctx)->async && CFG(ctx)->async->job.steps) return false;
+  if(OPS(ctx,stream)) return false;
+  if(LFTL_INVALID_POINTER != OPS(ctx,transaction_tracker)) return false;
+  return 0 == OPS(ctx,next_data);
+}
+
+// Static wear leveling: move the data of the least erased idle area of the 
+// pool onto the most erased free slot, so its slot gets back into circulation
+static void pool_migrate(lftl_pool_t*pool){
+  if(0 == pool->migrate_threshold) return;
+  lftl_ctx_t*cold = 0;
+  uint32_t cold_count = 0;
+  for(uint32_t i = 0; i < pool->n_areas; i++){
+    lftl_ctx_t*area = pool->areas[i];
+    if(!is_idle(area)) continue;
+    if(LFTL_INVALID_POINTER == ST(area,data)) find_current_slot(area);
+    //pending versions are left to the group commit
+    if(get_slot_version(area,get_current_slot_index(area)) & VERSION_PENDING) continue;
+    const uint32_t count = pool_erase_count(area,ST(area,data));
+    if((0 == cold) || (count < cold_count)){
+      cold = area;
+      cold_count = count;
+    }
+  }
+  if(0 == cold) return;
+  uint8_t*const worn = pool_free_slot(cold,true);
+  if(0 == worn) return;
+  if(pool_erase_count(cold,worn) <= cold_count + pool->migrate_threshold) return;
+  OPS(cold,next_data) = worn;
+  lftl_job_t job;
+  init_job(cold,&job,JOB_ERASE | JOB_COPY | JOB_META);
+  job.head_size = DATA_SIZE(cold);
+  while(!job_step(cold,&job,false));
+}
+
+static void run_job(lftl_ctx_t*ctx, lftl_job_t*job){
+  const bool migrate = POOL(ctx) && (job->steps & JOB_META) && !(job->steps & JOB_PENDING);
+  while(!job_step(ctx,job,false));
+  if(migrate) pool_migrate(POOL(ctx));
+}
+
+// Translate the source address if it is in an LFTL area and find the context to read it
+static const uint8_t*resolve_src(lftl_ctx_t*ctx, const void*const src, uintptr_t size, lftl_ctx_t**src_ctx){
+  const uint8_t* src_phy_addr = src;
+  *src_ctx = is_in_any_nvm(registry_of(ctx), src_phy_addr);
+  if(LFTL_INVALID_POINTER!=*src_ctx){
+    if(is_in_data(*src_ctx,src_phy_addr)){ // src is in an LFTL area
+      src_phy_addr = translate_addr(*src_ctx, (void*)src_phy_addr, size);
+    }
+  }else{
+    *src_ctx = ctx;
+  }
+  return src_phy_addr;
+}
+
+// merge the data into the cached write units, the first and last ones may be partial
+KERNEL void overlay_merge_kernel(uint32_t write_size, lftl_ctx_t*ctx, lftl_ctx_t*src_ctx, uintptr_t offset, const uint8_t*src8, uintptr_t size){
+  while(size){
+    const uintptr_t wu_offset = offset % write_size;
+    uintptr_t n = write_size - wu_offset;
+    if(n > size) n = size;
+    uint32_t*entry = overlay_get(ctx,offset / write_size);
+    mem_read(src_ctx,(uint8_t*)(entry+1) + wu_offset,src8,n);
+    offset += n;
+    src8 += n;
+    size -= n;
+  }
+}
+
+// merge a write of any alignment into the overlay
+static void overlay_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
+  check_idle(ctx);
+  if(0==size) return;
+  STATS_ADD(ctx,logical_bytes_written,size);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  translate_addr(ctx, dst_nvm_addr, size);
+  const uintptr_t offset = (uintptr_t)dst_nvm_addr - (uintptr_t)CFG(ctx)->area;
+  PROFILE_WRITE(ctx,offset,size);
+  lftl_ctx_t* src_ctx;
+  const uint8_t*src8 = resolve_src(ctx,src,size,&src_ctx);
+  WU_KERNEL(write_size,overlay_merge_kernel,ctx,src_ctx,offset,src8,size);
+}
+
+static void setup_write(lftl_ctx_t*ctx, lftl_job_t*job, void*const dst_nvm_addr, const void*const src, uintptr_t size, bool transaction, bool aligned){
+  check_idle(ctx);
+  STATS_ADD(ctx,logical_bytes_written,size);
+  PROFILE_WRITE(ctx,(uintptr_t)dst_nvm_addr - (uintptr_t)CFG(ctx)->area,size);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  uintptr_t dst_nvm_addr_aligned;
+  uintptr_t addr_misalignement;
+  uintptr_t size_aligned;
+  if(aligned){
+    // check that the args are indeed aligned
+    if(0 != ((uintptr_t)dst_nvm_addr % write_size)) CFG(ctx)->error_handler(LFTL_ERROR_BASE_MISALIGNED);
+    if(0 != (size % write_size)) CFG(ctx)->error_handler(LFTL_ERROR_SIZE_MISALIGNED);
+    addr_misalignement = 0;
+    dst_nvm_addr_aligned = (uintptr_t)dst_nvm_addr;
+    size_aligned = size;
+  } else {
+    // unaligned: extend the start address and end address to start of WU and end of WU respectively
+    addr_misalignement = ((uintptr_t)dst_nvm_addr % write_size);
+    dst_nvm_addr_aligned = (uintptr_t)dst_nvm_addr - addr_misalignement;
+    size_aligned = size + addr_misalignement;
+    if(0 != (size_aligned % write_size)){
+      size_aligned += write_size - size_aligned % write_size;
+    }
+  }
+  const void*const current_phy_addr = translate_addr(ctx, (void*)dst_nvm_addr_aligned, size_aligned);
+  const uintptr_t offset = (uintptr_t)current_phy_addr - (uintptr_t)ST(ctx,data);
+  if(!transaction){
+    if(LFTL_INVALID_POINTER != OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_TRANSACTION_ONGOING);
+  }
+  init_job(ctx,job,transaction ? JOB_BODY : JOB_ERASE | JOB_COPY | JOB_BODY | JOB_META);
+  job->head_size = offset;
+  job->end_offset = offset+size_aligned;
+  job->offset = offset;
+  job->misalignment = addr_misalignement;
+  lftl_ctx_t* src_ctx;
+  job->src = resolve_src(ctx,src,size,&src_ctx);
+  job->src_ctx = src_ctx;
+  job->size = size;
+}
+
+static void write_core(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size, bool transaction, bool aligned){
+  DEBUG_PRINTLN("write_core(%p,%p,%p,%u,%u,%u) entry",ctx,dst_nvm_addr,src,size,transaction,aligned);
+  lftl_job_t job;
+  setup_write(ctx,&job,dst_nvm_addr,src,size,transaction,aligned);
+  run_job(ctx,&job);
+  DEBUG_PRINTLN("write_core exit");
+}
+
+static void setup_erase(lftl_ctx_t*ctx, lftl_job_t*job, void*const dst_nvm_addr, uintptr_t size){
+  check_idle(ctx);
+  STATS_ADD(ctx,logical_bytes_written,size);
+  PROFILE_WRITE(ctx,(uintptr_t)dst_nvm_addr - (uintptr_t)CFG(ctx)->area,size);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  if(0 != ((uintptr_t)dst_nvm_addr % write_size)) CFG(ctx)->error_handler(LFTL_ERROR_BASE_MISALIGNED);
+  if(0 != (size % write_size)) CFG(ctx)->error_handler(LFTL_ERROR_SIZE_MISALIGNED);
+  const void*const current_phy_addr = translate_addr(ctx, dst_nvm_addr, size);
+  const uintptr_t offset = (uintptr_t)current_phy_addr - (uintptr_t)ST(ctx,data);
+  if(LFTL_INVALID_POINTER != OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_TRANSACTION_ONGOING);
+  init_job(ctx,job,JOB_ERASE | JOB_COPY | JOB_META);
+  job->head_size = offset;
+  job->end_offset = offset+size;
+}
+
+static void erase(lftl_ctx_t*ctx, void*const dst_nvm_addr, uintptr_t size){
+  DEBUG_PRINTLN("erase entry");
+  lftl_job_t job;
+  setup_erase(ctx,&job,dst_nvm_addr,size);
+  run_job(ctx,&job);
+  DEBUG_PRINTLN("erase exit");
+}
+
+static void setup_transaction_start(lftl_ctx_t*ctx, lftl_job_t*job, void *const transaction_tracker, uintptr_t compact_size){
+  check_idle(ctx);
+  require_ops(ctx);
+  if(LFTL_INVALID_POINTER != OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_TRANSACTION_ONGOING);
+  if(LFTL_INVALID_POINTER == ST(ctx,data)) find_current_slot(ctx);
+  tracker_init(ctx,transaction_tracker,compact_size);
+  OPS(ctx,overlay) = 0;
+  init_job(ctx,job,JOB_ERASE);
+}
+
+static void setup_transaction_commit(lftl_ctx_t*ctx, lftl_job_t*job){
+  check_idle(ctx);
+  if(LFTL_INVALID_POINTER == OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_NO_TRANSACTION);
+  overlay_flush(ctx);
+  init_job(ctx,job,JOB_GAPS | JOB_META | JOB_END_TRANSACTION);
+}
+
+#define xstr(s) str(s)
+#define str(s) #s
+static const char*version = xstr(GIT_VERSION);
+static const uint64_t version_timestamp = VERSION_TIMESTAMP;
+static const char*build_type = xstr(BUILD_TYPE);
+
+const char* lftl_version(){
+  return version;
+}
+
+uint64_t lftl_version_timestamp(){
+  return version_timestamp;
+}
+
+const char* lftl_build_type(){
+  return build_type;
+}
+
+void lftl_registry_init(lftl_registry_t*reg){
+  reg->has_several_nvms = 0;
+  reg->first_area = LFTL_INVALID_POINTER;
+  reg->last_area = LFTL_INVALID_POINTER;
+  reg->n_area_index = 0;
+  reg->n_nvm_index = 0;
+  reg->index_full = 0;
+  reg->last_hit = LFTL_INVALID_POINTER;
+}
+
+void lftl_init_lib(){
+  lftl_registry_init(&default_registry);
+}
+
+void lftl_registry_register_area(lftl_registry_t*reg, lftl_ctx_t*ctx){
+  init_cfg(ctx);
+#ifdef LFTL_STATIC_CONFIG
+  const lftl_area_cfg_t*cfg = CFG(ctx);
+  if((LFTL_INVALID_POINTER != reg->first_area) || cfg->pool ||
+     (cfg->nvm_props->write_size != WRITE_SIZE(ctx)) || (cfg->nvm_props->erase_size != ERASE_SIZE(ctx)) ||
+     (cfg->area_size != AREA_SIZE(ctx)) || (cfg->data_size != DATA_SIZE(ctx)) ||
+     (cfg->erase != LFTL_STATIC_ERASE) || (cfg->write != LFTL_STATIC_WRITE) || (cfg->read != LFTL_STATIC_READ)){
+    cfg->error_handler(LFTL_ERROR_STATIC_CONFIG);
+  }
+#endif
+  //the next slot of a pooled area is kept in its ops
+  if(POOL(ctx)) require_ops(ctx);
+  ST(ctx,registry) = reg;
+  if(LFTL_INVALID_POINTER==reg->first_area){
+    reg->first_area = ctx;
+  } else {
+    ST(reg->last_area,next) = ctx;
+    if(CFG(ctx)->nvm_props!=CFG(reg->first_area)->nvm_props) reg->has_several_nvms = 1;
+  }
+  reg->last_area = ctx;
+  ST(ctx,next) = reg->first_area;
+  if(reg->n_area_index==LFTL_MAX_AREAS){
+    reg->index_full = 1;
+    return;
+  }
+  index_insert(reg->area_index, &reg->n_area_index, ctx, 0);
+  for(uint32_t i=0;i<reg->n_nvm_index;i++){
+    if(CFG(reg->nvm_index[i])->nvm_props==CFG(ctx)->nvm_props) return;
+  }
+  index_insert(reg->nvm_index, &reg->n_nvm_index, ctx, 1);
+}
+
+void lftl_register_area(lftl_ctx_t*ctx){
+  lftl_registry_register_area(&default_registry, ctx);
+}
+
+static void pool_format(lftl_pool_t*pool){
+  for(uint32_t i = 0; i < pool->n_areas; i++){
+    lftl_ctx_t*ctx = pool->areas[i];
+    if(POOL(ctx) != pool) CFG(ctx)->error_handler(LFTL_ERROR_POOL_CONFIG);
+    if(CFG(ctx)->nvm_props != CFG(pool->areas[0])->nvm_props) CFG(ctx)->error_handler(LFTL_ERROR_POOL_CONFIG);
+    if(WRITE_SIZE(ctx)>LFTL_WU_MAX_SIZE) CFG(ctx)->error_handler(LFTL_ERROR_WU_SIZE_TOO_LARGE);
+    if((0 == pool->slot_size) || (pool->slot_size % page_size(ctx))) CFG(ctx)->error_handler(LFTL_ERROR_POOL_CONFIG);
+    if(DATA_SIZE(ctx) + meta_phy_size(ctx) > pool->slot_size) CFG(ctx)->error_handler(LFTL_ERROR_POOL_CONFIG);
+    if(AREA_SIZE(ctx) < pool->slot_size) CFG(ctx)->error_handler(LFTL_ERROR_POOL_CONFIG);
+    accessor_erase(ctx,CFG(ctx)->area,n_pages(ctx));
+  }
+  //each area starts in the first slot of its own pages
+  for(uint32_t i = 0; i < pool->n_areas; i++){
+    lftl_ctx_t*ctx = pool->areas[i];
+    lftl_meta_t meta;
+    meta.owner = i;
+    meta.erase_count = 1;
+    meta_items_worst_case_t buf;
+    pack_pool_meta(ctx,buf,&meta);
+    accessor_write(ctx,(uint8_t*)CFG(ctx)->area + meta_offset(ctx),buf,pool_meta_size(ctx));
+    set_data(ctx, CFG(ctx)->area);
+    OPS(ctx,next_data) = 0;
+    write_meta(ctx, slot_index_of(ctx,CFG(ctx)->area), 1);
+  }
+}
+
+void lftl_format(lftl_ctx_t*ctx){
+  DEBUG_PRINTLN("lftl_format entry");
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  if(POOL(ctx)){
+    pool_format(POOL(ctx));
+    DEBUG_PRINTLN("lftl_format exit");
+    UNLOCK(ctx);
+    TRACE_EXIT(ctx);
+    return;
+  }
+  if(WRITE_SIZE(ctx)>LFTL_WU_MAX_SIZE) CFG(ctx)->error_handler(LFTL_ERROR_WU_SIZE_TOO_LARGE);
+  accessor_erase(ctx,CFG(ctx)->area,n_pages(ctx));
+  set_data(ctx, CFG(ctx)->area);
+  write_meta(ctx, 0, 1);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  DEBUG_PRINTLN("lftl_format exit");
+}
+
+lftl_ctx_t*lftl_registry_get_ctx(lftl_registry_t*reg, const void*const addr){
+  return find_area(reg, addr);
+}
+
+lftl_ctx_t*lftl_get_ctx(const void*const addr){
+  return find_area(&default_registry, addr);
+}
+
+void lftl_erase_all(lftl_ctx_t*ctx){
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  erase(ctx, CFG(ctx)->area, DATA_SIZE(ctx));//dst_nvm_addr is area because erase function does the address translation
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_basic_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
+  if(0==size) return;
+  TRACE_ENTER(ctx,dst_nvm_addr,size);
+  LOCK(ctx);
+  write_core(ctx,dst_nvm_addr,src,size,NO_TRANSACTION,UNALIGNED);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+#ifdef LFTL_CONCURRENCY
+// read without taking the lock, retry if the current slot was switched meanwhile
+static void concurrent_read(lftl_ctx_t*ctx, void*dst, const void*const src_nvm_addr, uintptr_t size){
+  if(LFTL_INVALID_POINTER == __atomic_load_n(&ST(ctx,data), __ATOMIC_ACQUIRE)){
+    LOCK(ctx);//mounting may repair meta data
+    translate_addr(ctx, src_nvm_addr, size);
+    UNLOCK(ctx);
+  }
+  uint32_t seq;
+  do{
+    seq = __atomic_load_n(&ST(ctx,data_seq), __ATOMIC_ACQUIRE);
+    const void*const phy_addr = translate_addr(ctx, src_nvm_addr, size);
+    accessor_read(ctx,dst, phy_addr, size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  }while(seq != __atomic_load_n(&ST(ctx,data_seq), __ATOMIC_RELAXED));
+}
+#endif
+
+void lftl_read(lftl_ctx_t*ctx, void*dst, const void*const src_nvm_addr, uintptr_t size){
+  DEBUG_PRINTLN("lftl_read entry");
+  if(0==size) return;
+  TRACE_ENTER(ctx,src_nvm_addr,size);
+#ifdef LFTL_CONCURRENCY
+  if(CFG(ctx)->lock){
+    concurrent_read(ctx,dst,src_nvm_addr,size);
+    TRACE_EXIT(ctx);
+    DEBUG_PRINTLN("lftl_read exit");
+    return;
+  }
+#endif
+  const void*const phy_addr = translate_addr(ctx, src_nvm_addr, size);
+  accessor_read(ctx,dst, phy_addr, size);
+  TRACE_EXIT(ctx);
+  DEBUG_PRINTLN("lftl_read exit");
+}
+
+void lftl_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker){
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  lftl_job_t job;
+  setup_transaction_start(ctx,&job,transaction_tracker,0);
+  run_job(ctx,&job);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_transaction_start_compact(lftl_ctx_t*ctx, void *const transaction_tracker, uintptr_t tracker_size){
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  //the header and one range, a size of 0 would also select the bitmap tracker
+  if(tracker_size < LFTL_COMPACT_TRACKER_SIZE(1)) CFG(ctx)->error_handler(LFTL_ERROR_TRACKER_FULL);
+  lftl_job_t job;
+  setup_transaction_start(ctx,&job,transaction_tracker,tracker_size);
+  run_job(ctx,&job);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_transaction_start_overlay(lftl_ctx_t*ctx, void *const transaction_tracker, lftl_overlay_t*overlay){
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  if(0 == overlay->n_entries) CFG(ctx)->error_handler(LFTL_ERROR_OVERLAY_INVALID);
+  lftl_transaction_start(ctx,transaction_tracker);
+  OPS(ctx,overlay) = overlay;
+  memset(overlay->entries,0xFF,overlay->n_entries*LFTL_OVERLAY_ENTRY_SIZE_LL(WRITE_SIZE(ctx)));
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_transaction_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
+  TRACE_ENTER(ctx,dst_nvm_addr,size);
+  LOCK(ctx);
+  if(LFTL_INVALID_POINTER == OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_NO_TRANSACTION);
+  if(OPS(ctx,overlay)){
+    overlay_write(ctx,dst_nvm_addr,src,size);
+    UNLOCK(ctx);
+    TRACE_EXIT(ctx);
+    return;
+  }
+  check_idle(ctx);
+  //check/update transaction tracker
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  tracker_set(ctx, dst_nvm_addr, size / write_size);
+  write_core(ctx,dst_nvm_addr,src,size,TRANSACTION, ALIGNED);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+static void transaction_write_any_tracker_set(lftl_ctx_t*ctx, void*const dst_nvm_addr, uintptr_t size){
+  if(LFTL_INVALID_POINTER == OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_NO_TRANSACTION);
+  check_idle(ctx);
+  //check/update transaction tracker
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uintptr_t addr_misalignement = ((uintptr_t)dst_nvm_addr % write_size);
+  const uintptr_t dst_nvm_addr_aligned = (uintptr_t)dst_nvm_addr - addr_misalignement;
+  const uint32_t n_write_units = LFTL_DIV_CEIL(size+addr_misalignement,write_size);
+  tracker_set(ctx, (void*)dst_nvm_addr_aligned, n_write_units);
+}
+
+void lftl_transaction_write_any(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
+  TRACE_ENTER(ctx,dst_nvm_addr,size);
+  LOCK(ctx);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uintptr_t addr_misalignement = ((uintptr_t)dst_nvm_addr % write_size);
+  const bool addr_is_aligned = 0 == addr_misalignement;
+  const bool size_is_aligned = 0 == (size % write_size);
+  if(OPS(ctx,overlay)) {
+    lftl_transaction_write(ctx, dst_nvm_addr, src, size);
+  } else if(addr_is_aligned & size_is_aligned) {
+    lftl_transaction_write(ctx, dst_nvm_addr, src, size);
+  } else {
+    transaction_write_any_tracker_set(ctx, dst_nvm_addr, size);
+    write_core(ctx,dst_nvm_addr,src,size,TRANSACTION, UNALIGNED);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_transaction_commit(lftl_ctx_t*ctx){
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  lftl_job_t job;
+  setup_transaction_commit(ctx,&job);
+  run_job(ctx,&job);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_transaction_abort(lftl_ctx_t*ctx){
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  check_idle(ctx);
+  OPS(ctx,transaction_tracker) = LFTL_INVALID_POINTER;
+  OPS(ctx,overlay) = 0;
+  OPS(ctx,next_data) = 0;
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_transaction_read(lftl_ctx_t*ctx, void*dst, const void*const src_nvm_addr, uintptr_t size){
+  if(LFTL_INVALID_POINTER == OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_NO_TRANSACTION);
+  if(0==size) return;
+  TRACE_ENTER(ctx,src_nvm_addr,size);
+  LOCK(ctx);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uint32_t n_write_units = size / write_size;
+  const uintptr_t offset = (uintptr_t)src_nvm_addr - (uintptr_t)CFG(ctx)->area;
+  const uint32_t offset_wu = offset / write_size;
+  uint8_t*const base = next_slot_base(ctx);
+  uint8_t*dst8 = (uint8_t*)dst;
+  for(uintptr_t i = 0; i < n_write_units; i++){
+    const uint32_t wu_index = offset_wu+i;
+    const uint32_t*entry = overlay_find(ctx,wu_index);
+    if(entry) {
+      //read new data from the overlay
+      memcpy(dst8, entry+1, write_size);
+    }else if(tracker_is_set(ctx,wu_index)) {
+      //read new data
+      void*phy_addr = base + wu_index*write_size;
+      accessor_read(ctx,dst8, phy_addr, write_size);
+    }else{
+      //read current data
+      void*phy_addr = (uint8_t*)(ST(ctx,data)) + wu_index*write_size;
+      accessor_read(ctx,dst8, phy_addr, write_size);
+    }
+    dst8 += write_size;
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
+  if(0==size) return;
+  TRACE_ENTER(ctx,dst_nvm_addr,size);
+  LOCK(ctx);
+  if(OPS(ctx,transaction_tracker) == LFTL_INVALID_POINTER){
+    lftl_basic_write(ctx, dst_nvm_addr, src, size);
+  } else {
+    lftl_transaction_write(ctx, dst_nvm_addr, src, size);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_write_any(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
+  if(0==size) return;
+  TRACE_ENTER(ctx,dst_nvm_addr,size);
+  LOCK(ctx);
+  if(OPS(ctx,transaction_tracker) == LFTL_INVALID_POINTER){
+    lftl_basic_write(ctx, dst_nvm_addr, src, size);
+  } else {
+    lftl_transaction_write_any(ctx, dst_nvm_addr, src, size);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_read_newer(lftl_ctx_t*ctx, void*dst, const void*const src_nvm_addr, uintptr_t size){
+  if(0==size) return;
+  DEBUG_PRINTLN("lftl_read_newer entry");
+  TRACE_ENTER(ctx,src_nvm_addr,size);
+  LOCK(ctx);
+  if(OPS(ctx,transaction_tracker) == LFTL_INVALID_POINTER){
+    lftl_read(ctx, dst, src_nvm_addr, size);
+  } else {
+    lftl_transaction_read(ctx, dst, src_nvm_addr, size);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
   DEBUG_PRINTLN("lftl_read_newer exit");
 }
 
-void lftl_memread(void*dst, const void*const src, uintptr_t size){
+void lftl_registry_memread(lftl_registry_t*reg, void*dst, const void*const src, uintptr_t size){
   DEBUG_PRINTLN("lftl_memread entry");
-  lftl_ctx_t*ctx = is_in_any_nvm(src);
+  lftl_ctx_t*ctx = is_in_any_nvm(reg, src);
   if(LFTL_INVALID_POINTER==ctx) { // regular memory
     memcpy(dst,src,size);
   } else { // NVM, in or out of any LFTL area
     if(is_in_data(ctx,src)) lftl_read(ctx,dst,src,size);
-    else nvm_read(ctx,dst,src,size); // outside of LFTL area but within NVM
+    else accessor_read(ctx,dst,src,size); // outside of LFTL area but within NVM
   }
   DEBUG_PRINTLN("lftl_memread exit");
 }
 
-void lftl_memread_newer(void*dst, const void*const src, uintptr_t size){
+void lftl_registry_memread_newer(lftl_registry_t*reg, void*dst, const void*const src, uintptr_t size){
   DEBUG_PRINTLN("lftl_memread_newer entry");
-  lftl_ctx_t*ctx = is_in_any_nvm(src);
+  lftl_ctx_t*ctx = is_in_any_nvm(reg, src);
   if(LFTL_INVALID_POINTER==ctx) { // regular memory
     memcpy(dst,src,size);
   } else { // NVM, in or out of any LFTL area
     if(is_in_data(ctx,src)) lftl_read_newer(ctx,dst,src,size);
-    else nvm_read(ctx,dst,src,size); // outside of LFTL area but within NVM
+    else accessor_read(ctx,dst,src,size); // outside of LFTL area but within NVM
   }
   DEBUG_PRINTLN("lftl_memread_newer exit");
 }
+
+void lftl_memread(void*dst, const void*const src, uintptr_t size){
+  lftl_registry_memread(&default_registry, dst, src, size);
+}
+
+void lftl_memread_newer(void*dst, const void*const src, uintptr_t size){
+  lftl_registry_memread_newer(&default_registry, dst, src, size);
+}
+
+const void*lftl_get_ptr(lftl_ctx_t*ctx, const void*const nvm_addr, uintptr_t size, uint32_t*generation){
+  TRACE_ENTER(ctx,nvm_addr,size);
+  LOCK(ctx);
+  if(!CFG(ctx)->nvm_props->memory_mapped) CFG(ctx)->error_handler(LFTL_ERROR_NOT_MAPPED);
+  const void*const phy_addr = translate_addr(ctx, nvm_addr, size);
+  if(generation) *generation = lftl_generation(ctx);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  return phy_addr;
+}
+
+uint32_t lftl_generation(lftl_ctx_t*ctx){
+#ifdef LFTL_CONCURRENCY
+  return __atomic_load_n(&ST(ctx,data_seq), __ATOMIC_ACQUIRE);
+#else
+  return ST(ctx,data_seq);
+#endif
+}
+
+static void check_group(lftl_group_t*group){
+  for(uint32_t i = 0; i < group->n_members; i++){
+    lftl_ctx_t*ctx = group->members[i];
+    if(CFG(ctx)->group != group) CFG(ctx)->error_handler(LFTL_ERROR_NOT_IN_GROUP);
+  }
+}
+
+void lftl_group_transaction_start(lftl_group_t*group, void *const*transaction_trackers){
+  check_group(group);
+  LOCK(group->record);
+  for(uint32_t i = 0; i < group->n_members; i++){
+    lftl_transaction_start(group->members[i],transaction_trackers[i]);
+  }
+  UNLOCK(group->record);
+}
+
+void lftl_group_transaction_commit(lftl_group_t*group){
+  DEBUG_PRINTLN("lftl_group_transaction_commit entry");
+  check_group(group);
+  lftl_ctx_t*record = group->record;
+  LOCK(record);
+  group_record_item_t*const acknowledged = (group_record_item_t*)CFG(record)->area;
+  //stage the new version of each member
+  for(uint32_t i = 0; i < group->n_members; i++){
+    lftl_ctx_t*ctx = group->members[i];
+    if(LFTL_INVALID_POINTER == OPS(ctx,transaction_tracker)) continue;
+    lftl_job_t job;
+    setup_transaction_commit(ctx,&job);
+    job.steps |= JOB_PENDING;
+    run_job(ctx,&job);
+  }
+  //single commit point: acknowledge all new versions at once
+  lftl_stream_t stream;
+  lftl_stream_begin(record,&stream,acknowledged);
+  for(uint32_t i = 0; i < group->n_members; i++){
+    lftl_ctx_t*ctx = group->members[i];
+    if(LFTL_INVALID_POINTER == ST(ctx,data)) find_current_slot(ctx);
+    const unsigned int slot_index = get_current_slot_index(ctx);
+    group_record_item_t item;
+    item[0] = get_slot_version(ctx,slot_index);
+    if(item[0] & VERSION_PENDING) {
+      item[0] = version_number(item[0]);
+      item[1] = get_slot_checksum(ctx,slot_index);
+    } else {
+      lftl_read(record,item,acknowledged + i,sizeof(item));//keep previous value
+    }
+    lftl_stream_append(record,&stream,item,sizeof(item));
+  }
+  lftl_stream_commit(record,&stream);
+  UNLOCK(record);
+  DEBUG_PRINTLN("lftl_group_transaction_commit exit");
+}
+
+void lftl_group_transaction_abort(lftl_group_t*group){
+  LOCK(group->record);
+  for(uint32_t i = 0; i < group->n_members; i++){
+    lftl_ctx_t*ctx = group->members[i];
+    if(LFTL_INVALID_POINTER != OPS(ctx,transaction_tracker)) lftl_transaction_abort(ctx);
+  }
+  UNLOCK(group->record);
+}
+
+static void check_stream(lftl_ctx_t*ctx, lftl_stream_t*stream){
+  if((0 == stream) || (OPS(ctx,stream) != stream)) CFG(ctx)->error_handler(LFTL_ERROR_NO_STREAM);
+}
+
+// write the partial write unit buffer
+static void stream_flush_wu(lftl_ctx_t*ctx, lftl_stream_t*stream){
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  lftl_job_t*job = &stream->job;
+  STATS_ADD(ctx,crc_bytes,write_size);
+  job->crc = crc32c(job->crc,job->wu,write_size);
+  job_write_wu(ctx,false,job->base + job->offset,(const uint8_t*)job->wu);
+  job->offset += write_size;
+  stream->fill = 0;
+}
+
+void lftl_stream_begin(lftl_ctx_t*ctx, lftl_stream_t*stream, void*const dst_nvm_addr){
+  DEBUG_PRINTLN("lftl_stream_begin entry");
+  TRACE_ENTER(ctx,dst_nvm_addr,0);
+  LOCK(ctx);
+  check_idle(ctx);
+  require_ops(ctx);
+  if(LFTL_INVALID_POINTER != OPS(ctx,transaction_tracker)) CFG(ctx)->error_handler(LFTL_ERROR_TRANSACTION_ONGOING);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const void*const current_phy_addr = translate_addr(ctx, dst_nvm_addr, 0);
+  const uintptr_t offset = (uintptr_t)current_phy_addr - (uintptr_t)ST(ctx,data);
+  const uintptr_t misalignment = offset % write_size;
+  lftl_job_t*job = &stream->job;
+  init_job(ctx,job,JOB_ERASE | JOB_COPY);
+  job->head_size = offset - misalignment;
+  //erase the next slot and copy the data before the written range
+  run_job(ctx,job);
+  job->offset = job->head_size;
+  job->crc = checksum(ctx,ST(ctx,data),job->head_size);
+  accessor_read(ctx,job->wu,(const uint8_t*)ST(ctx,data) + job->offset,misalignment);
+  stream->fill = misalignment;
+  OPS(ctx,stream) = stream;
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  DEBUG_PRINTLN("lftl_stream_begin exit");
+}
+
+void lftl_stream_append(lftl_ctx_t*ctx, lftl_stream_t*stream, const void*const src, uintptr_t size){
+  check_stream(ctx,stream);
+  if(0==size) return;
+  TRACE_ENTER(ctx,0,size);
+  LOCK(ctx);
+  STATS_ADD(ctx,logical_bytes_written,size);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  lftl_job_t*job = &stream->job;
+  PROFILE_WRITE(ctx,job->offset + stream->fill,size);
+  if(job->offset + stream->fill + size > DATA_SIZE(ctx)) CFG(ctx)->error_handler(LFTL_ERROR_LAST_NOT_IN_DATA);
+  lftl_ctx_t*src_ctx;
+  const uint8_t*src8 = resolve_src(ctx,src,size,&src_ctx);
+  uint8_t*const wu = (uint8_t*)job->wu;
+  while(size){
+    uintptr_t n;
+    if(stream->fill || (size < write_size)){
+      //buffer partial write unit
+      n = write_size - stream->fill;
+      if(n > size) n = size;
+      mem_read(src_ctx,wu + stream->fill,src8,n);
+      stream->fill += n;
+      if(stream->fill == write_size) stream_flush_wu(ctx,stream);
+    } else {
+      n = size - size % write_size;
+      job->crc = checksum_update(src_ctx,job->crc,src8,n);
+      while(!job_range(ctx,job,false,src_ctx,job->base + job->offset,src8,n));
+      job->offset += n;
+    }
+    src8 += n;
+    size -= n;
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_stream_commit(lftl_ctx_t*ctx, lftl_stream_t*stream){
+  DEBUG_PRINTLN("lftl_stream_commit entry");
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  check_stream(ctx,stream);
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uint8_t*const current_base = (const uint8_t*)ST(ctx,data);
+  lftl_job_t*job = &stream->job;
+  if(stream->fill){
+    //complete the last write unit with current data
+    uint8_t*const wu = (uint8_t*)job->wu;
+    accessor_read(ctx,wu + stream->fill,current_base + job->offset + stream->fill,write_size - stream->fill);
+    stream_flush_wu(ctx,stream);
+  }
+  //copy the data after the written range and write meta data
+  job->crc = checksum_update(ctx,job->crc,current_base + job->offset,DATA_SIZE(ctx) - job->offset);
+  job->steps = JOB_COPY | JOB_META | JOB_CRC;
+  job->phase = PHASE_TAIL;
+  job->end_offset = job->offset;
+  run_job(ctx,job);
+  OPS(ctx,stream) = 0;
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  DEBUG_PRINTLN("lftl_stream_commit exit");
+}
+
+void lftl_stream_abort(lftl_ctx_t*ctx, lftl_stream_t*stream){
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  check_stream(ctx,stream);
+  OPS(ctx,stream) = 0;
+  OPS(ctx,next_data) = 0;
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+static uintptr_t wu_round_up(lftl_ctx_t*ctx, uintptr_t size){
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  return (size + write_size - 1) / write_size * write_size;
+}
+
+// Program data outside of LFTL areas, padded to write units
+static void program_padded(lftl_ctx_t*ctx, uint8_t*dst, const void*const src, uintptr_t size){
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uintptr_t body_size = size - size % write_size;
+  accessor_write(ctx,dst,src,body_size);
+  if(size > body_size){
+    uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+    memset(buf,CFG(ctx)->nvm_props->erased_value,write_size);
+    memcpy(buf,(const uint8_t*)src + body_size,size - body_size);
+    accessor_write(ctx,dst + body_size,buf,write_size);
+  }
+}
+
+// Program a write unit outside of LFTL areas with a value which is not erased
+static void program_marker(lftl_ctx_t*ctx, uint8_t*dst){
+  uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+  memset(buf,~CFG(ctx)->nvm_props->erased_value,WRITE_SIZE(ctx));
+  accessor_write(ctx,dst,buf,WRITE_SIZE(ctx));
+}
+
+// Program a record outside of LFTL areas: the header and then the value, each padded to write units.
+// The header is programmed first so an erased header marks the end of the records.
+static void program_record(lftl_ctx_t*ctx, uint8_t*dst, const void*const header, uintptr_t header_size, const void*const value, uintptr_t value_size){
+  program_padded(ctx,dst,header,header_size);
+  program_padded(ctx,dst + wu_round_up(ctx,header_size),value,value_size);
+}
+
+// Key-value store
+// The LFTL area holds a kv_snapshot_t followed by packed records: a kv_record_t and the value.
+// The log holds a kv_log_header_t followed by records made of a kv_record_t and the value, 
+// both padded to write units. The header of a record is programmed before its value
+// so an erased header marks the end of the log.
+#define KV_MAGIC 0x564B4C46
+#define KV_IN_LOG 0x80000000 // flag of lftl_kv_entry_t.offset
+
+typedef struct kv_snapshot_struct {
+  uint32_t magic;
+  uint32_t seq;   // the log is valid only if its header has the same seq
+  uint32_t size;  // size of the records
+} kv_snapshot_t;
+
+typedef struct kv_log_header_struct {
+  uint32_t magic;
+  uint32_t seq;
+} kv_log_header_t;
+
+typedef struct kv_record_struct {
+  uint16_t key;
+  uint16_t size;  // LFTL_KV_NOT_FOUND for a deletion
+  uint32_t crc;   // of key, size and value
+} kv_record_t;
+
+
+static uintptr_t kv_value_size(uint16_t size){
+  return LFTL_KV_NOT_FOUND == size ? 0 : size;
+}
+
+static uintptr_t kv_log_record_size(lftl_ctx_t*ctx, uint16_t size){
+  return wu_round_up(ctx,sizeof(kv_record_t)) + wu_round_up(ctx,kv_value_size(size));
+}
+
+// Find the index entry of a key, allocate it if requested.
+// Returns 0 if the key is not found or if the index is full.
+static lftl_kv_entry_t*kv_entry(lftl_kv_t*kv, uint16_t key, bool alloc){
+  const uint32_t mask = kv->index_size - 1;
+  uint32_t i = ((uint32_t)key * 0x9E3779B1) >> 16;
+  for(uint32_t n = 0; n < kv->index_size; n++){
+    lftl_kv_entry_t*entry = &kv->index[i & mask];
+    if(entry->key == key) return entry;
+    if(LFTL_KV_NO_KEY == entry->key){
+      if(!alloc) return 0;
+      entry->key = key;
+      entry->size = LFTL_KV_NOT_FOUND;
+      return entry;
+    }
+    i++;
+  }
+  return 0;
+}
+
+static void kv_index_set(lftl_kv_t*kv, lftl_kv_entry_t*entry, uint16_t size, uint32_t offset){
+  if(LFTL_KV_NOT_FOUND != entry->size) kv->live_size -= sizeof(kv_record_t) + entry->size;
+  if(LFTL_KV_NOT_FOUND != size) kv->live_size += sizeof(kv_record_t) + size;
+  entry->size = size;
+  entry->offset = offset;
+}
+
+static void kv_index_record(lftl_kv_t*kv, const kv_record_t*record, uint32_t offset){
+  const bool deletion = LFTL_KV_NOT_FOUND == record->size;
+  lftl_kv_entry_t*entry = kv_entry(kv,record->key,!deletion);
+  if(0 == entry){
+    if(!deletion) CFG(kv->ctx)->error_handler(LFTL_ERROR_KV_FULL);
+    return;
+  }
+  kv_index_set(kv,entry,record->size,offset);
+}
+
+static const uint8_t*kv_record_addr(lftl_kv_t*kv, const lftl_kv_entry_t*entry){
+  if(entry->offset & KV_IN_LOG) return (const uint8_t*)kv->log + (entry->offset & ~KV_IN_LOG);
+  return (const uint8_t*)CFG(kv->ctx)->area + entry->offset;
+}
+
+static const uint8_t*kv_value_addr(lftl_kv_t*kv, const lftl_kv_entry_t*entry){
+  const uintptr_t header_size = (entry->offset & KV_IN_LOG) ? wu_round_up(kv->ctx,sizeof(kv_record_t)) : sizeof(kv_record_t);
+  return kv_record_addr(kv,entry) + header_size;
+}
+
+// read from the LFTL area or from the log
+static void kv_read(lftl_kv_t*kv, void*dst, const void*const src, uintptr_t size){
+  if(is_in_data(kv->ctx,src)) lftl_read(kv->ctx,dst,src,size);
+  else accessor_read(kv->ctx,dst,src,size);
+}
+
+static bool kv_value_equals(lftl_kv_t*kv, const lftl_kv_entry_t*entry, const void*const value, uint16_t size){
+  if(entry->size != size) return false;
+  const uint8_t*src = kv_value_addr(kv,entry);
+  const uint8_t*value8 = (const uint8_t*)value;
+  uint64_t buf[8];
+  while(size){
+    const uint16_t n = size > sizeof(buf) ? sizeof(buf) : size;
+    kv_read(kv,buf,src,n);
+    if(memcmp(buf,value8,n)) return false;
+    src += n;
+    value8 += n;
+    size -= n;
+  }
+  return true;
+}
+
+static void kv_index_snapshot(lftl_kv_t*kv, uint32_t size){
+  lftl_ctx_t*ctx = kv->ctx;
+  const uint8_t*const area = (const uint8_t*)CFG(ctx)->area;
+  for(uint32_t i = 0; i < kv->index_size; i++) kv->index[i].key = LFTL_KV_NO_KEY;
+  kv->live_size = 0;
+  uint32_t offset = sizeof(kv_snapshot_t);
+  const uint32_t end = offset + size;
+  while(offset < end){
+    kv_record_t record;
+    lftl_read(ctx,&record,area + offset,sizeof(record));
+    kv_index_record(kv,&record,offset);
+    offset += sizeof(record) + record.size;
+  }
+}
+
+static void kv_reset_log(lftl_kv_t*kv){
+  lftl_ctx_t*ctx = kv->ctx;
+  const kv_log_header_t header = {.magic = KV_MAGIC, .seq = kv->seq};
+  accessor_erase(ctx,kv->log,kv->log_size / ERASE_SIZE(ctx));
+  program_record(ctx,kv->log,&header,sizeof(header),0,0);
+  kv->log_fill = wu_round_up(ctx,sizeof(header));
+}
+
+static void kv_index_log(lftl_kv_t*kv){
+  lftl_ctx_t*ctx = kv->ctx;
+  const uintptr_t header_size = wu_round_up(ctx,sizeof(kv_record_t));
+  uintptr_t offset = wu_round_up(ctx,sizeof(kv_log_header_t));
+  while(offset + header_size <= kv->log_size){
+    const uint8_t*const addr = (const uint8_t*)kv->log + offset;
+    uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+    accessor_read(ctx,buf,addr,header_size);
+    if(is_erased(ctx,(const uint8_t*)buf,header_size)) break;
+    kv_record_t record;
+    memcpy(&record,buf,sizeof(record));
+    bool valid = (LFTL_KV_NO_KEY != record.key) && (offset + kv_log_record_size(ctx,record.size) <= kv->log_size);
+    if(valid){
+      const uint32_t crc = crc32c(0xFFFFFFFF,&record,offsetof(kv_record_t,crc));
+      valid = record.crc == checksum_update(ctx,crc,addr + header_size,kv_value_size(record.size));
+    }
+    if(!valid){
+      //torn record: the log is compacted at the next update
+      offset = kv->log_size;
+      break;
+    }
+    kv_index_record(kv,&record,offset | KV_IN_LOG);
+    offset += kv_log_record_size(ctx,record.size);
+  }
+  kv->log_fill = offset;
+}
+
+static void kv_append(lftl_kv_t*kv, uint16_t key, const void*const value, uint16_t size){
+  lftl_ctx_t*ctx = kv->ctx;
+  const uintptr_t value_size = kv_value_size(size);
+  kv_record_t record = {.key = key, .size = size};
+  STATS_ADD(ctx,crc_bytes,value_size);
+  record.crc = crc32c(crc32c(0xFFFFFFFF,&record,offsetof(kv_record_t,crc)),value,value_size);
+  program_record(ctx,(uint8_t*)kv->log + kv->log_fill,&record,sizeof(record),value,value_size);
+  kv->log_fill += kv_log_record_size(ctx,size);
+}
+
+static void kv_compact(lftl_kv_t*kv){
+  lftl_ctx_t*ctx = kv->ctx;
+  const kv_snapshot_t snapshot = {.magic = KV_MAGIC, .seq = kv->seq + 1, .size = kv->live_size};
+  lftl_stream_t stream;
+  lftl_stream_begin(ctx,&stream,CFG(ctx)->area);
+  lftl_stream_append(ctx,&stream,&snapshot,sizeof(snapshot));
+  for(uint32_t i = 0; i < kv->index_size; i++){
+    const lftl_kv_entry_t*entry = &kv->index[i];
+    if((LFTL_KV_NO_KEY == entry->key) || (LFTL_KV_NOT_FOUND == entry->size)) continue;
+    lftl_stream_append(ctx,&stream,kv_record_addr(kv,entry),sizeof(kv_record_t));
+    lftl_stream_append(ctx,&stream,kv_value_addr(kv,entry),entry->size);
+  }
+  //the log becomes stale as soon as the new snapshot is visible
+  lftl_stream_commit(ctx,&stream);
+  kv->seq = snapshot.seq;
+  kv_reset_log(kv);
+  kv_index_snapshot(kv,snapshot.size);
+}
+
+static void kv_update(lftl_kv_t*kv, lftl_kv_entry_t*entry, uint16_t key, const void*const value, uint16_t size){
+  if(kv->log_fill + kv_log_record_size(kv->ctx,size) > kv->log_size){
+    kv_compact(kv);
+    entry = kv_entry(kv,key,true);
+  }
+  const uint32_t offset = kv->log_fill | KV_IN_LOG;
+  kv_append(kv,key,value,size);
+  kv_index_set(kv,entry,size,offset);
+}
+
+void lftl_kv_mount(lftl_kv_t*kv){
+  lftl_ctx_t*ctx = kv->ctx;
+  init_cfg(ctx);
+  TRACE_ENTER(ctx,kv->log,kv->log_size);
+  LOCK(ctx);
+  const uint32_t erase_size = ERASE_SIZE(ctx);
+  if(((uintptr_t)kv->log % erase_size) || (kv->log_size % erase_size) || (kv->log_size >= KV_IN_LOG) ||
+     (kv->log_size <= wu_round_up(ctx,sizeof(kv_log_header_t)) + wu_round_up(ctx,sizeof(kv_record_t))) ||
+     (0 == kv->index_size) || (kv->index_size & (kv->index_size - 1)) || (DATA_SIZE(ctx) < sizeof(kv_snapshot_t))){
+    CFG(ctx)->error_handler(LFTL_ERROR_KV_INVALID);
+  }
+  kv_snapshot_t snapshot;
+  kv_log_header_t log_header;
+  lftl_read(ctx,&snapshot,CFG(ctx)->area,sizeof(snapshot));
+  accessor_read(ctx,&log_header,kv->log,sizeof(log_header));
+  if((KV_MAGIC != snapshot.magic) || (snapshot.size > DATA_SIZE(ctx) - sizeof(kv_snapshot_t))){
+    //new store, its seq shall not match the one of a stale log
+    snapshot.magic = KV_MAGIC;
+    snapshot.seq = KV_MAGIC == log_header.magic ? log_header.seq + 1 : 0;
+    snapshot.size = 0;
+    lftl_write(ctx,CFG(ctx)->area,&snapshot,sizeof(snapshot));
+  }
+  kv->seq = snapshot.seq;
+  kv_index_snapshot(kv,snapshot.size);
+  if((KV_MAGIC == log_header.magic) && (log_header.seq == kv->seq)){
+    kv_index_log(kv);
+  } else {
+    kv_reset_log(kv);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_kv_set(lftl_kv_t*kv, uint16_t key, const void*const value, uint16_t size){
+  lftl_ctx_t*ctx = kv->ctx;
+  TRACE_ENTER(ctx,value,size);
+  LOCK(ctx);
+  if((LFTL_KV_NO_KEY == key) || (size > LFTL_KV_MAX_VALUE_SIZE)) CFG(ctx)->error_handler(LFTL_ERROR_KV_INVALID);
+  lftl_kv_entry_t*entry = kv_entry(kv,key,true);
+  if(0 == entry) CFG(ctx)->error_handler(LFTL_ERROR_KV_FULL);
+  if(!kv_value_equals(kv,entry,value,size)){
+    //check now that the record fits in the log and the live records in the LFTL area
+    const uintptr_t old_size = LFTL_KV_NOT_FOUND == entry->size ? 0 : sizeof(kv_record_t) + entry->size;
+    const uintptr_t live_size = kv->live_size - old_size + sizeof(kv_record_t) + size;
+    const uintptr_t log_capacity = kv->log_size - wu_round_up(ctx,sizeof(kv_log_header_t));
+    if((live_size > DATA_SIZE(ctx) - sizeof(kv_snapshot_t)) || (kv_log_record_size(ctx,size) > log_capacity)){
+      CFG(ctx)->error_handler(LFTL_ERROR_KV_FULL);
+    }
+    kv_update(kv,entry,key,value,size);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+uint16_t lftl_kv_get(lftl_kv_t*kv, uint16_t key, void*dst, uint16_t max_size){
+  lftl_ctx_t*ctx = kv->ctx;
+  TRACE_ENTER(ctx,dst,max_size);
+  LOCK(ctx);
+  const lftl_kv_entry_t*entry = kv_entry(kv,key,false);
+  const uint16_t size = entry ? entry->size : LFTL_KV_NOT_FOUND;
+  if(LFTL_KV_NOT_FOUND != size) kv_read(kv,dst,kv_value_addr(kv,entry),size < max_size ? size : max_size);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  return size;
+}
+
+void lftl_kv_delete(lftl_kv_t*kv, uint16_t key){
+  lftl_ctx_t*ctx = kv->ctx;
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  lftl_kv_entry_t*entry = kv_entry(kv,key,false);
+  if(entry && (LFTL_KV_NOT_FOUND != entry->size)) kv_update(kv,entry,key,0,LFTL_KV_NOT_FOUND);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_kv_compact(lftl_kv_t*kv){
+  lftl_ctx_t*ctx = kv->ctx;
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  kv_compact(kv);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+// Ring log
+// Each page starts with a log_page_header_t and a marker write unit, followed by records made 
+// of a log_record_t and the payload, both padded to write units. Pages are used in ring order with 
+// consecutive sequence numbers; a page is erased only when it becomes the head, 
+// so the pages which are not erased, from page 0 to the head, have consecutive sequence numbers.
+// The markers are used only by FIFOs: the page marker is programmed once all entries of the page
+// are consumed and each entry has a marker between its header and its payload.
+#define LOG_MAGIC 0x474F4C46
+#define LOG_RECORD_DATA 0x0001
+#define LOG_RECORD_TRIM 0x0002 // payload is a log_position_t, the new tail
+#define LOG_RECORD_ENTRY 0x0003 // FIFO entry
+#define LOG_NO_RECORD 0
+#define LOG_INVALID_RECORD UINTPTR_MAX
+
+typedef struct log_position_struct {
+  uint32_t seq;     // sequence number of the page
+  uint32_t offset;  // offset of the record in the page
+} log_position_t;
+
+typedef struct log_page_header_struct {
+  uint32_t magic;
+  uint32_t seq;
+  log_position_t tail;  // tail when the page became the head
+  uint32_t crc;
+} log_page_header_t;
+
+typedef struct log_record_struct {
+  uint16_t size;
+  uint16_t type;
+  uint32_t crc;     // of size, type and payload
+} log_record_t;
+
+static uint32_t log_n_pages(lftl_log_t*log){
+  return CFG(log->ctx)->area_size / ERASE_SIZE(log->ctx);
+}
+
+static uint8_t*log_page(lftl_log_t*log, uint32_t page){
+  return (uint8_t*)CFG(log->ctx)->area + page * ERASE_SIZE(log->ctx);
+}
+
+static uintptr_t log_page_marker(lftl_log_t*log){
+  return wu_round_up(log->ctx,sizeof(log_page_header_t));
+}
+
+static uintptr_t log_first_record(lftl_log_t*log){
+  return log_page_marker(log) + WRITE_SIZE(log->ctx);
+}
+
+static uintptr_t log_marker_size(lftl_log_t*log, uint16_t type){
+  return LOG_RECORD_ENTRY == type ? WRITE_SIZE(log->ctx) : 0;
+}
+
+static uintptr_t log_record_size(lftl_log_t*log, uint16_t type, uint16_t size){
+  return wu_round_up(log->ctx,sizeof(log_record_t)) + log_marker_size(log,type) + wu_round_up(log->ctx,size);
+}
+
+static bool log_page_header(lftl_log_t*log, uint32_t page, log_page_header_t*header){
+  accessor_read(log->ctx,header,log_page(log,page),sizeof(log_page_header_t));
+  return (LOG_MAGIC == header->magic) && (header->crc == crc32c(0xFFFFFFFF,header,offsetof(log_page_header_t,crc)));
+}
+
+// Page holding the records of a sequence number, it is within the last n_pages pages up to the head
+static uint32_t log_page_of(lftl_log_t*log, uint32_t seq){
+  const uint32_t n = log_n_pages(log);
+  return (log->head + n - (log->head_seq - seq)) % n;
+}
+
+// Size of the record at addr, LOG_NO_RECORD if it is erased, LOG_INVALID_RECORD if it is torn
+static uintptr_t log_record_at(lftl_log_t*log, const uint8_t*addr, uintptr_t room, log_record_t*record){
+  lftl_ctx_t*ctx = log->ctx;
+  const uintptr_t header_size = wu_round_up(ctx,sizeof(log_record_t));
+  if(header_size > room) return LOG_NO_RECORD;
+  uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+  accessor_read(ctx,buf,addr,header_size);
+  if(is_erased(ctx,(const uint8_t*)buf,header_size)) return LOG_NO_RECORD;
+  memcpy(record,buf,sizeof(log_record_t));
+  if((LOG_RECORD_DATA != record->type) && (LOG_RECORD_TRIM != record->type) && (LOG_RECORD_ENTRY != record->type)) return LOG_INVALID_RECORD;
+  if((LOG_RECORD_TRIM == record->type) && (sizeof(log_position_t) != record->size)) return LOG_INVALID_RECORD;
+  const uintptr_t size = log_record_size(log,record->type,record->size);
+  if(size > room) return LOG_INVALID_RECORD;
+  //the marker of an entry is not covered by the CRC
+  const uint32_t crc = crc32c(0xFFFFFFFF,record,offsetof(log_record_t,crc));
+  if(record->crc != checksum_update(ctx,crc,addr + header_size + log_marker_size(log,record->type),record->size)) return LOG_INVALID_RECORD;
+  return size;
+}
+
+static void log_program(lftl_log_t*log, uint16_t type, const void*const payload, uint16_t size);
+
+// Erase the page after the head and make it the head
+static void log_open_page(lftl_log_t*log){
+  lftl_ctx_t*ctx = log->ctx;
+  const uint32_t n = log_n_pages(log);
+  const uint32_t page = (log->head + 1) % n;
+  const uint32_t seq = log->head_seq + 1;
+  if(seq - log->tail_seq >= n){
+    //the page holds the oldest records
+    if(!log->overwrite) CFG(ctx)->error_handler(LFTL_ERROR_LOG_FULL);
+    log->tail_seq = seq - n + 1;
+    log->tail_offset = log_first_record(log);
+  }
+  log_page_header_t header = {.magic = LOG_MAGIC, .seq = seq, .tail = {.seq = log->tail_seq, .offset = log->tail_offset}};
+  header.crc = crc32c(0xFFFFFFFF,&header,offsetof(log_page_header_t,crc));
+  accessor_erase(ctx,log_page(log,page),1);
+  program_record(ctx,log_page(log,page),&header,sizeof(header),0,0);
+  log->head = page;
+  log->head_seq = seq;
+  log->head_fill = log_first_record(log);
+}
+
+static void log_program(lftl_log_t*log, uint16_t type, const void*const payload, uint16_t size){
+  lftl_ctx_t*ctx = log->ctx;
+  const uintptr_t record_size = log_record_size(log,type,size);
+  if(record_size > ERASE_SIZE(ctx) - log_first_record(log)) CFG(ctx)->error_handler(LFTL_ERROR_LOG_INVALID);
+  if(log->head_fill + record_size > ERASE_SIZE(ctx)) log_open_page(log);
+  log_record_t record = {.size = size, .type = type};
+  STATS_ADD(ctx,crc_bytes,size);
+  record.crc = crc32c(crc32c(0xFFFFFFFF,&record,offsetof(log_record_t,crc)),payload,size);
+  uint8_t*const dst = log_page(log,log->head) + log->head_fill;
+  program_padded(ctx,dst,&record,sizeof(record));
+  program_padded(ctx,dst + wu_round_up(ctx,sizeof(record)) + log_marker_size(log,type),payload,size);
+  log->head_fill += record_size;
+}
+
+// Visit up to max_records data records from the tail, return the number of records visited.
+// pos is set to the first record which is not visited.
+static uint32_t log_walk(lftl_log_t*log, uint32_t max_records, lftl_log_visitor_t visitor, void*user, void*buf, uint16_t buf_size, log_position_t*pos){
+  lftl_ctx_t*ctx = log->ctx;
+  const uintptr_t header_size = wu_round_up(ctx,sizeof(log_record_t));
+  uint32_t n_records = 0;
+  pos->seq = log->tail_seq;
+  pos->offset = log->tail_offset;
+  while((int32_t)(log->head_seq - pos->seq) >= 0){
+    const bool is_head = pos->seq == log->head_seq;
+    const uintptr_t end = is_head ? log->head_fill : ERASE_SIZE(ctx);
+    const uint8_t*const page = log_page(log,log_page_of(log,pos->seq));
+    log_page_header_t header;
+    const bool valid = is_head || (log_page_header(log,log_page_of(log,pos->seq),&header) && (header.seq == pos->seq));
+    while(valid && (pos->offset < end)){
+      log_record_t record;
+      const uintptr_t size = log_record_at(log,page + pos->offset,end - pos->offset,&record);
+      if((LOG_NO_RECORD == size) || (LOG_INVALID_RECORD == size)) break;
+      if(LOG_RECORD_DATA == record.type){
+        if(n_records == max_records) return n_records;
+        n_records++;
+        if(visitor){
+          accessor_read(ctx,buf,page + pos->offset + header_size,record.size < buf_size ? record.size : buf_size);
+          if(visitor(user,buf,record.size)){
+            pos->offset += size;
+            return n_records;
+          }
+        }
+      }
+      pos->offset += size;
+    }
+    if(is_head) break;
+    pos->seq++;
+    pos->offset = log_first_record(log);
+  }
+  pos->seq = log->head_seq;
+  pos->offset = log->head_fill;
+  return n_records;
+}
+
+void lftl_log_format(lftl_log_t*log){
+  lftl_ctx_t*ctx = log->ctx;
+  init_cfg(ctx);
+  TRACE_ENTER(ctx,CFG(ctx)->area,CFG(ctx)->area_size);
+  LOCK(ctx);
+  accessor_erase(ctx,CFG(ctx)->area,log_n_pages(log));
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+// Find the head and the tail recorded in the head page
+static void log_mount(lftl_log_t*log){
+  lftl_ctx_t*ctx = log->ctx;
+  const uint32_t erase_size = ERASE_SIZE(ctx);
+  if(((uintptr_t)CFG(ctx)->area % erase_size) || (CFG(ctx)->area_size % erase_size) || (log_n_pages(log) < 2)){
+    CFG(ctx)->error_handler(LFTL_ERROR_LOG_INVALID);
+  }
+  const uint32_t n = log_n_pages(log);
+  log_page_header_t header;
+  uint32_t head = n - 1; //page 0 is erased: the log is empty or page 0 was torn while becoming the head
+  if(log_page_header(log,0,&header)){
+    //binary search of the last page with a sequence number consecutive to the one of page 0
+    const uint32_t seq0 = header.seq;
+    uint32_t lo = 0;
+    uint32_t hi = n;
+    while(hi - lo > 1){
+      const uint32_t mid = lo + (hi - lo) / 2;
+      if(log_page_header(log,mid,&header) && (header.seq - seq0 == mid)) lo = mid;
+      else hi = mid;
+    }
+    head = lo;
+  }
+  log->head = head;
+  if(log_page_header(log,head,&header)){
+    log->head_seq = header.seq;
+    log->tail_seq = header.tail.seq;
+    log->tail_offset = header.tail.offset;
+    //scan the head page for its end and for trim records
+    const uint8_t*const page = log_page(log,head);
+    uintptr_t offset = log_first_record(log);
+    while(offset < erase_size){
+      log_record_t record;
+      const uintptr_t size = log_record_at(log,page + offset,erase_size - offset,&record);
+      if(LOG_NO_RECORD == size) break;
+      if(LOG_INVALID_RECORD == size){
+        //torn record: the next record goes to the next page
+        offset = erase_size;
+        break;
+      }
+      if(LOG_RECORD_TRIM == record.type){
+        log_position_t tail;
+        accessor_read(ctx,&tail,page + offset + wu_round_up(ctx,sizeof(log_record_t)),sizeof(tail));
+        log->tail_seq = tail.seq;
+        log->tail_offset = tail.offset;
+      }
+      offset += size;
+    }
+    log->head_fill = offset;
+    if(log->head_seq - log->tail_seq >= n){
+      log->tail_seq = log->head_seq - n + 1;
+      log->tail_offset = log_first_record(log);
+    }
+  } else {
+    //empty log: the first record opens page 0
+    log->head_seq = 0xFFFFFFFF;
+    log->head_fill = erase_size;
+    log->tail_seq = 0;
+    log->tail_offset = log_first_record(log);
+  }
+}
+
+void lftl_log_mount(lftl_log_t*log){
+  lftl_ctx_t*ctx = log->ctx;
+  //the context of a log is not registered
+  init_cfg(ctx);
+  TRACE_ENTER(ctx,CFG(ctx)->area,CFG(ctx)->area_size);
+  LOCK(ctx);
+  log_mount(log);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_log_append(lftl_log_t*log, const void*const record, uint16_t size){
+  lftl_ctx_t*ctx = log->ctx;
+  TRACE_ENTER(ctx,record,size);
+  LOCK(ctx);
+  STATS_ADD(ctx,logical_bytes_written,size);
+  log_program(log,LOG_RECORD_DATA,record,size);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+uint32_t lftl_log_iterate(lftl_log_t*log, lftl_log_visitor_t visitor, void*user, void*buf, uint16_t buf_size){
+  lftl_ctx_t*ctx = log->ctx;
+  TRACE_ENTER(ctx,buf,buf_size);
+  LOCK(ctx);
+  log_position_t pos;
+  const uint32_t n_records = log_walk(log,0xFFFFFFFF,visitor,user,buf,buf_size,&pos);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  return n_records;
+}
+
+void lftl_log_trim(lftl_log_t*log, uint32_t n_records){
+  lftl_ctx_t*ctx = log->ctx;
+  TRACE_ENTER(ctx,0,n_records);
+  LOCK(ctx);
+  log_position_t tail;
+  if(log_walk(log,n_records,0,0,0,0,&tail)){
+    //the new tail is set before the record is programmed: it may let a full log open a page
+    log->tail_seq = tail.seq;
+    log->tail_offset = tail.offset;
+    log_program(log,LOG_RECORD_TRIM,&tail,sizeof(tail));
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+// FIFO
+// A FIFO is a ring log of entries without overwrite: its tail is the oldest entry which is not consumed.
+// Pages are consumed in order, so the tail page is found by binary search over the page markers.
+
+// Whether the page of a sequence number holds no entry to consume
+static bool fifo_page_consumed(lftl_log_t*log, uint32_t seq){
+  lftl_ctx_t*ctx = log->ctx;
+  const uint32_t page = log_page_of(log,seq);
+  log_page_header_t header;
+  if(!log_page_header(log,page,&header) || (header.seq != seq)) return true;
+  uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+  accessor_read(ctx,buf,log_page(log,page) + log_page_marker(log),WRITE_SIZE(ctx));
+  return !wu_is_erased(ctx,(const uint8_t*)buf);
+}
+
+// Move the tail to the next page while it is at the end of a page which is not the head
+static void fifo_skip_consumed(lftl_log_t*log){
+  lftl_ctx_t*ctx = log->ctx;
+  while((int32_t)(log->head_seq - log->tail_seq) > 0){
+    uint8_t*const page = log_page(log,log_page_of(log,log->tail_seq));
+    log_record_t record;
+    const uintptr_t size = log_record_at(log,page + log->tail_offset,ERASE_SIZE(ctx) - log->tail_offset,&record);
+    if((LOG_NO_RECORD != size) && (LOG_INVALID_RECORD != size)) return;
+    //fifo_page_consumed reads the marker: a torn one is not programmed again
+    if(!fifo_page_consumed(log,log->tail_seq)) program_marker(ctx,page + log_page_marker(log));
+    log->tail_seq++;
+    log->tail_offset = log_first_record(log);
+  }
+}
+
+void lftl_fifo_format(lftl_fifo_t*fifo){
+  lftl_log_format(&fifo->log);
+}
+
+void lftl_fifo_mount(lftl_fifo_t*fifo){
+  lftl_log_t*log = &fifo->log;
+  lftl_ctx_t*ctx = log->ctx;
+  init_cfg(ctx);
+  TRACE_ENTER(ctx,CFG(ctx)->area,CFG(ctx)->area_size);
+  LOCK(ctx);
+  log->overwrite = 0;
+  log_mount(log);
+  if((int32_t)(log->head_seq - log->tail_seq) >= 0){
+    //binary search of the first page which is not consumed, the head page is never marked
+    const uint32_t n = log_n_pages(log);
+    const uint32_t oldest = log->head_seq - (n - 1);
+    uint32_t lo = 0;
+    uint32_t hi = n - 1;
+    while(lo < hi){
+      const uint32_t mid = lo + (hi - lo) / 2;
+      if(fifo_page_consumed(log,oldest + mid)) lo = mid + 1;
+      else hi = mid;
+    }
+    log->tail_seq = oldest + lo;
+    //scan the tail page for the first entry which is not consumed
+    const uint8_t*const page = log_page(log,log_page_of(log,log->tail_seq));
+    const uintptr_t end = log->tail_seq == log->head_seq ? log->head_fill : ERASE_SIZE(ctx);
+    const uintptr_t header_size = wu_round_up(ctx,sizeof(log_record_t));
+    uintptr_t offset = log_first_record(log);
+    while(offset < end){
+      log_record_t record;
+      const uintptr_t size = log_record_at(log,page + offset,end - offset,&record);
+      if((LOG_NO_RECORD == size) || (LOG_INVALID_RECORD == size)) break;
+      uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+      accessor_read(ctx,buf,page + offset + header_size,WRITE_SIZE(ctx));
+      if((LOG_RECORD_ENTRY == record.type) && wu_is_erased(ctx,(const uint8_t*)buf)) break;
+      offset += size;
+    }
+    log->tail_offset = offset;
+    fifo_skip_consumed(log);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_fifo_enqueue(lftl_fifo_t*fifo, const void*const entry, uint16_t size){
+  lftl_log_t*log = &fifo->log;
+  lftl_ctx_t*ctx = log->ctx;
+  TRACE_ENTER(ctx,entry,size);
+  LOCK(ctx);
+  STATS_ADD(ctx,logical_bytes_written,size);
+  //the tail may be at the end of the previous head page
+  fifo_skip_consumed(log);
+  log_program(log,LOG_RECORD_ENTRY,entry,size);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+uint16_t lftl_fifo_dequeue(lftl_fifo_t*fifo, void*dst, uint16_t max_size){
+  lftl_log_t*log = &fifo->log;
+  lftl_ctx_t*ctx = log->ctx;
+  TRACE_ENTER(ctx,dst,max_size);
+  LOCK(ctx);
+  uint16_t entry_size = LFTL_FIFO_EMPTY;
+  fifo_skip_consumed(log);
+  if((int32_t)(log->head_seq - log->tail_seq) >= 0){
+    uint8_t*const page = log_page(log,log_page_of(log,log->tail_seq));
+    const uintptr_t end = log->tail_seq == log->head_seq ? log->head_fill : ERASE_SIZE(ctx);
+    log_record_t record;
+    const uintptr_t size = log_record_at(log,page + log->tail_offset,end - log->tail_offset,&record);
+    if((LOG_NO_RECORD != size) && (LOG_INVALID_RECORD != size)){
+      const uintptr_t header_size = wu_round_up(ctx,sizeof(log_record_t));
+      accessor_read(ctx,dst,page + log->tail_offset + header_size + log_marker_size(log,record.type),record.size < max_size ? record.size : max_size);
+      if(LOG_RECORD_ENTRY == record.type){
+        //a marker torn by a reset may read as erased during the mount, it is never programmed again
+        uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+        accessor_read(ctx,buf,page + log->tail_offset + header_size,WRITE_SIZE(ctx));
+        if(wu_is_erased(ctx,(const uint8_t*)buf)) program_marker(ctx,page + log->tail_offset + header_size);
+      }
+      log->tail_offset += size;
+      //mark the page as soon as it is consumed so the head can reuse it
+      fifo_skip_consumed(log);
+      entry_size = record.size;
+    }
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  return entry_size;
+}
+
+// Monotonic counters
+// The region starts with a counter_header_t, then each increment programs the next write unit.
+// The value is the base value stored in the LFTL area plus the number of programmed write units.
+// When the region is exhausted, the value is written as the new base along with a new sequence
+// number, then the region is erased: a region whose sequence number differs from the base is stale.
+#define COUNTER_MAGIC 0x544E4346
+
+typedef struct counter_base_struct {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t value;
+} counter_base_t;
+
+typedef struct counter_header_struct {
+  uint32_t magic;
+  uint32_t seq;
+} counter_header_t;
+
+static uint32_t counter_n_slots(lftl_counter_t*counter){
+  lftl_ctx_t*ctx = counter->ctx;
+  return (counter->region_size - wu_round_up(ctx,sizeof(counter_header_t))) / WRITE_SIZE(ctx);
+}
+
+static uint8_t*counter_slot(lftl_counter_t*counter, uint32_t slot){
+  lftl_ctx_t*ctx = counter->ctx;
+  return (uint8_t*)counter->region + wu_round_up(ctx,sizeof(counter_header_t)) + slot * WRITE_SIZE(ctx);
+}
+
+static void counter_reset_region(lftl_counter_t*counter){
+  lftl_ctx_t*ctx = counter->ctx;
+  const counter_header_t header = {.magic = COUNTER_MAGIC, .seq = counter->seq};
+  accessor_erase(ctx,counter->region,counter->region_size / ERASE_SIZE(ctx));
+  program_record(ctx,counter->region,&header,sizeof(header),0,0);
+  counter->count = 0;
+}
+
+// Number of programmed slots: they are programmed in order, so the first erased one is found by binary search
+static uint32_t counter_count(lftl_counter_t*counter){
+  lftl_ctx_t*ctx = counter->ctx;
+  uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+  uint32_t lo = 0;
+  uint32_t hi = counter_n_slots(counter);
+  while(lo < hi){
+    const uint32_t mid = lo + (hi - lo) / 2;
+    accessor_read(ctx,buf,counter_slot(counter,mid),WRITE_SIZE(ctx));
+    if(wu_is_erased(ctx,(const uint8_t*)buf)) hi = mid;
+    else lo = mid + 1;
+  }
+  return lo;
+}
+
+void lftl_counter_mount(lftl_counter_t*counter){
+  lftl_ctx_t*ctx = counter->ctx;
+  init_cfg(ctx);
+  TRACE_ENTER(ctx,counter->region,counter->region_size);
+  LOCK(ctx);
+  const uint32_t erase_size = ERASE_SIZE(ctx);
+  if(((uintptr_t)counter->region % erase_size) || (counter->region_size % erase_size) ||
+     (counter->region_size <= wu_round_up(ctx,sizeof(counter_header_t)))){
+    CFG(ctx)->error_handler(LFTL_ERROR_COUNTER_INVALID);
+  }
+  counter_base_t base;
+  counter_header_t header;
+  lftl_read(ctx,&base,counter->base,sizeof(base));
+  accessor_read(ctx,&header,counter->region,sizeof(header));
+  if(COUNTER_MAGIC != base.magic){
+    //new counter, its seq shall not match the one of a stale region
+    base.magic = COUNTER_MAGIC;
+    base.seq = COUNTER_MAGIC == header.magic ? header.seq + 1 : 0;
+    base.value = 0;
+    lftl_write(ctx,counter->base,&base,sizeof(base));
+  }
+  counter->seq = base.seq;
+  counter->value = base.value;
+  if((COUNTER_MAGIC == header.magic) && (header.seq == counter->seq)){
+    counter->count = counter_count(counter);
+  } else {
+    counter_reset_region(counter);
+  }
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+uint32_t lftl_counter_read(lftl_counter_t*counter){
+  lftl_ctx_t*ctx = counter->ctx;
+  TRACE_ENTER(ctx,counter->base,0);
+  LOCK(ctx);
+  const uint32_t value = counter->value + counter->count;
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  return value;
+}
+
+uint32_t lftl_counter_increment(lftl_counter_t*counter){
+  lftl_ctx_t*ctx = counter->ctx;
+  TRACE_ENTER(ctx,counter->base,0);
+  LOCK(ctx);
+  uint64_t buf[SIZE64(LFTL_WU_MAX_SIZE)];
+  for(;;){
+    if(counter->count == counter_n_slots(counter)){
+      //the new base makes the region stale before it is erased
+      const counter_base_t base = {.magic = COUNTER_MAGIC, .seq = counter->seq + 1, .value = counter->value + counter->count};
+      lftl_write(ctx,counter->base,&base,sizeof(base));
+      counter->seq = base.seq;
+      counter->value = base.value;
+      counter_reset_region(counter);
+    }
+    //a torn marker may read as erased during the mount: a slot which is not fully erased is consumed, never programmed again
+    accessor_read(ctx,buf,counter_slot(counter,counter->count),WRITE_SIZE(ctx));
+    if(wu_is_erased(ctx,(const uint8_t*)buf)) break;
+    counter->count++;
+  }
+  STATS_ADD(ctx,logical_bytes_written,sizeof(uint32_t));
+  program_marker(ctx,counter_slot(counter,counter->count));
+  counter->count++;
+  const uint32_t value = counter->value + counter->count;
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+  return value;
+}
+
+static lftl_job_t*get_async_job(lftl_ctx_t*ctx){
+  if(0 == CFG(ctx)->async) CFG(ctx)->error_handler(LFTL_ERROR_NO_ASYNC);
+  check_idle(ctx);
+  return &CFG(ctx)->async->job;
+}
+
+void lftl_async_write(lftl_ctx_t*ctx, void*const dst_nvm_addr, const void*const src, uintptr_t size){
+  lftl_job_t*job = get_async_job(ctx);
+  if(0==size) return;
+  TRACE_ENTER(ctx,dst_nvm_addr,size);
+  LOCK(ctx);
+  if(OPS(ctx,transaction_tracker) == LFTL_INVALID_POINTER){
+    setup_write(ctx,job,dst_nvm_addr,src,size,NO_TRANSACTION,UNALIGNED);
+  } else if(OPS(ctx,overlay)){
+    overlay_write(ctx,dst_nvm_addr,src,size);
+    UNLOCK(ctx);
+    TRACE_EXIT(ctx);
+    return;
+  } else {
+    transaction_write_any_tracker_set(ctx, dst_nvm_addr, size);
+    setup_write(ctx,job,dst_nvm_addr,src,size,TRANSACTION,UNALIGNED);
+  }
+  lftl_async_poll(ctx);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_async_erase_all(lftl_ctx_t*ctx){
+  lftl_job_t*job = get_async_job(ctx);
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  setup_erase(ctx,job,CFG(ctx)->area,DATA_SIZE(ctx));
+  lftl_async_poll(ctx);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_async_transaction_start(lftl_ctx_t*ctx, void *const transaction_tracker){
+  lftl_job_t*job = get_async_job(ctx);
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  setup_transaction_start(ctx,job,transaction_tracker,0);
+  lftl_async_poll(ctx);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+void lftl_async_transaction_commit(lftl_ctx_t*ctx){
+  lftl_job_t*job = get_async_job(ctx);
+  TRACE_ENTER(ctx,0,0);
+  LOCK(ctx);
+  setup_transaction_commit(ctx,job);
+  lftl_async_poll(ctx);
+  UNLOCK(ctx);
+  TRACE_EXIT(ctx);
+}
+
+static uint8_t async_poll(lftl_ctx_t*ctx){
+  lftl_job_t*job = &CFG(ctx)->async->job;
+  if(0 == job->steps) return LFTL_ASYNC_DONE;
+  TRACE_START(ctx,"poll_busy",0,0);
+  const uint8_t status = CFG(ctx)->async->poll_busy();
+  TRACE_END(ctx,"poll_busy");
+  if(LFTL_ASYNC_BUSY == status) return LFTL_ASYNC_BUSY;
+  if(status) {
+    job->steps = 0;
+    CFG(ctx)->error_handler(LFTL_ERROR_LOW_LEVEL_POLL | status);
+  }
+  return job_step(ctx,job,true) ? LFTL_ASYNC_DONE : LFTL_ASYNC_BUSY;
+}
+
+uint8_t lftl_async_poll(lftl_ctx_t*ctx){
+  if(0 == CFG(ctx)->async) CFG(ctx)->error_handler(LFTL_ERROR_NO_ASYNC);
+  LOCK(ctx);
+  const uint8_t status = async_poll(ctx);
+  UNLOCK(ctx);
+  return status;
+}
+
+void lftl_pool_erase_counts(lftl_pool_t*pool, uint32_t*min, uint32_t*max){
+  lftl_ctx_t*ctx = pool->areas[0];
+  const unsigned int ns = n_slots(ctx);
+  *min = 0xFFFFFFFF;
+  *max = 0;
+  for(unsigned int i = 0; i < ns; i++){
+    lftl_meta_t meta;
+    get_slot_meta(ctx,&meta,i);
+    if(meta.owner >= pool->n_areas) continue;
+    if(meta.erase_count < *min) *min = meta.erase_count;
+    if(meta.erase_count > *max) *max = meta.erase_count;
+  }
+}
+
+uint32_t lftl_profile_writes(lftl_ctx_t*ctx, const void*const nvm_addr, uintptr_t size){
+  uint32_t writes = 0;
+  lftl_profile_t*const profile = CFG(ctx)->profile;
+  if(0 == profile) return 0;
+  const uint32_t write_size = WRITE_SIZE(ctx);
+  const uintptr_t offset = (uintptr_t)nvm_addr - (uintptr_t)CFG(ctx)->area;
+  for(uintptr_t i = offset / write_size; (i < profile->n_wu) && (i * write_size < offset + size); i++){
+    if(profile->wu_writes[i] > writes) writes = profile->wu_writes[i];
+  }
+  return writes;
+}
+
+void lftl_get_stats(lftl_ctx_t*ctx, lftl_stats_t*stats){
+  memset(stats,0,sizeof(lftl_stats_t));
+  if(CFG(ctx)->stats) *stats = *CFG(ctx)->stats;
+  if(stats->logical_bytes_written){
+    stats->write_amplification = stats->programmed_bytes * 1000 / stats->logical_bytes_written;
+  }
+}
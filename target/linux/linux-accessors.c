@@ -72,6 +72,8 @@ extern uintptr_t nvm_size;
 extern uint32_t nvm_alignement;
 extern const char*save_nvm_file_name;
 extern bool trace_accessors;
+extern uint32_t nvm_erase_busy_us;
+extern uint32_t nvm_write_busy_us;
 
 uint32_t get_alignement_requirement(uint32_t original_req){
   if(original_req > nvm_alignement) return nvm_alignement;
@@ -114,6 +116,19 @@ uint8_t nvm_write(void*dst_nvm_addr, const void*const src, uintptr_t size){
   return tearing ? SIMULATED_TEARING:0;
 }
 
+uint8_t nvm_copy(void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size){
+  if(trace_accessors){
+    printf("nvm_copy @0x%08lx to @0x%08lx, %lu bytes\n\r",(uintptr_t)src_nvm_addr,(uintptr_t)dst_nvm_addr,size);
+  }
+  if(src_nvm_addr < nvm_base) return 5;
+  if(((uintptr_t)src_nvm_addr + size) > ((uintptr_t)nvm_base + nvm_size)) return 6;
+  const bool trace = trace_accessors;
+  trace_accessors = false;
+  uint8_t status = nvm_write(dst_nvm_addr, src_nvm_addr, size);
+  trace_accessors = trace;
+  return status;
+}
+
 uint8_t nvm_read(void* dst, const void*const src_nvm_addr, uintptr_t size){
   memcpy(dst,src_nvm_addr,size);
   if(trace_accessors){
@@ -121,4 +136,50 @@ uint8_t nvm_read(void* dst, const void*const src_nvm_addr, uintptr_t size){
     dump_core((uintptr_t)dst,size,(uintptr_t)src_nvm_addr);
   }
   return 0;
-}
\ No newline at end of file
+}
+//Asynchronous accessors: the operation is performed immediately but the NVM
+//stays busy for a configurable time to simulate a real flash controller
+static struct timespec nvm_busy_until;
+
+static void nvm_set_busy(uint64_t busy_us){
+  clock_gettime(CLOCK_MONOTONIC, &nvm_busy_until);
+  const uint64_t nsec = nvm_busy_until.tv_nsec + busy_us * 1000;
+  nvm_busy_until.tv_sec += nsec / 1000000000;
+  nvm_busy_until.tv_nsec = nsec % 1000000000;
+}
+
+uint8_t nvm_poll_busy(){
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if(now.tv_sec < nvm_busy_until.tv_sec) return 1;
+  if((now.tv_sec == nvm_busy_until.tv_sec) && (now.tv_nsec < nvm_busy_until.tv_nsec)) return 1;
+  return 0;
+}
+
+uint8_t nvm_start_erase(void*base_address, unsigned int n_pages){
+  if(nvm_poll_busy()) return 6;
+  uint8_t status = nvm_erase(base_address, n_pages);
+  nvm_set_busy((uint64_t)n_pages * nvm_erase_busy_us);
+  return status;
+}
+
+uint8_t nvm_start_write(void*dst_nvm_addr, const void*const src, uintptr_t size){
+  if(nvm_poll_busy()) return 6;
+  uint8_t status = nvm_write(dst_nvm_addr, src, size);
+  nvm_set_busy((uint64_t)(size / nvm_write_size) * nvm_write_busy_us);
+  return status;
+}
+
+uint8_t nvm_start_copy(void*dst_nvm_addr, const void*const src_nvm_addr, uintptr_t size){
+  if(nvm_poll_busy()) return 6;
+  uint8_t status = nvm_copy(dst_nvm_addr, src_nvm_addr, size);
+  nvm_set_busy((uint64_t)(size / nvm_write_size) * nvm_write_busy_us);
+  return status;
+}
+
+//clock for trace timestamps, in nanoseconds, wraps around every ~4.3s
+uint32_t nvm_clock(){
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
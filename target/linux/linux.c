@@ -139,6 +139,8 @@ void dump(uintptr_t addr, uintptr_t size){
 const void* nvm_base = &nvm;
 const uintptr_t nvm_size = sizeof(nvm);
 bool trace_accessors=0;
+uint32_t nvm_erase_busy_us=0;
+uint32_t nvm_write_busy_us=0;
 //Application level HAL
 void init(int argc, const char*argv[]){
   init_nvm_alignement();
@@ -153,6 +155,16 @@ void init(int argc, const char*argv[]){
       trace_accessors = 1;
       continue;
     }
+    const char*erase_busy_str = "--erase-busy-us=";
+    if(0==strncmp(argv[i],erase_busy_str,strlen(erase_busy_str))){
+      nvm_erase_busy_us = strtoul(argv[i]+strlen(erase_busy_str),0,0);
+      continue;
+    }
+    const char*write_busy_str = "--write-busy-us=";
+    if(0==strncmp(argv[i],write_busy_str,strlen(write_busy_str))){
+      nvm_write_busy_us = strtoul(argv[i]+strlen(write_busy_str),0,0);
+      continue;
+    }
     printf("ERROR unsupported command line argument: '%s'\n",argv[i]);
     abort();
   }
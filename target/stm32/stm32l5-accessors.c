@@ -204,3 +204,13 @@ uint8_t __attribute__((weak)) nvm_write(void*dst_nvm_addr, const void*const src,
   return fail;
 }
 
+
+//clock for trace timestamps, in CPU cycles
+uint32_t __attribute__((weak)) nvm_clock(){
+  if(0 == READ_BIT(DWT->CTRL, DWT_CTRL_CYCCNTENA_Msk)){
+    SET_BIT(CoreDebug->DEMCR, CoreDebug_DEMCR_TRCENA_Msk);
+    DWT->CYCCNT = 0;
+    SET_BIT(DWT->CTRL, DWT_CTRL_CYCCNTENA_Msk);
+  }
+  return DWT->CYCCNT;
+}
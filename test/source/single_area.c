@@ -0,0 +1,199 @@
+//Single area test: format, writes, transactions and reads on one area with the geometry
+//of LFTL_STATIC_CONFIG_DEFS, under the tearing simulation of the linux target.
+//It is built against the generic library and against the LFTL_STATIC_CONFIG one (SINGLE_AREA_STATIC),
+//both print the time of each operation to compare the two builds on the host.
+#include <stdint.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#include <string.h>
+
+#include "util.h"
+#include "type.h"
+#include "error.h"
+
+//linux target
+uint8_t nvm_erase(void*base_address, unsigned int n_pages);
+uint8_t nvm_write(void*dst_nvm_addr, const void*const src, uintptr_t size);
+uint8_t nvm_read(void* dst, const void*const src_nvm_addr, uintptr_t size);
+void init_nvm_alignement();
+uint32_t nvm_clock();
+void tearing_sim_init();
+uint32_t tearing_sim_get_max_target();
+void tearing_sim_set_target(uint64_t target_write);
+
+//the C++ tests are not part of this program, their pages hold the area
+data_flash_t nvm __attribute__ ((section (".data_flash")));
+_Static_assert(sizeof(nvm.cpp_pages) == LFTL_STATIC_AREA_SIZE, "the area does not match LFTL_STATIC_AREA_SIZE");
+#define DATA ((uint8_t*)&nvm.cpp_pages)
+
+static jmp_buf exception_ctx;
+void throw_exception(uint32_t err_code){
+  longjmp(exception_ctx,err_code);
+}
+
+lftl_nvm_props_t nvm_props = {
+  .base = &nvm,
+  .size = sizeof(nvm),
+  .write_size = LFTL_STATIC_WRITE_SIZE,
+  .erase_size = LFTL_STATIC_ERASE_SIZE,
+  .erased_value = 0xFF,
+  .memory_mapped = 1,
+};
+
+lftl_ctx_t area = {
+  .nvm_props = &nvm_props,
+  .area = &nvm.cpp_pages,
+  .area_size = LFTL_STATIC_AREA_SIZE,
+  .data = LFTL_INVALID_POINTER,
+  .data_size = LFTL_STATIC_DATA_SIZE,
+  .erase = nvm_erase,
+  .write = nvm_write,
+  .read = nvm_read,
+  .error_handler = throw_exception,
+  .transaction_tracker = LFTL_INVALID_POINTER,
+  .next = LFTL_INVALID_POINTER,
+};
+
+//content of the data after the last operation, and before it
+static uint8_t model[LFTL_STATIC_DATA_SIZE];
+static uint8_t model_previous[LFTL_STATIC_DATA_SIZE];
+
+#define N_ITERATIONS 8
+
+static uint32_t prng_state;
+static void prng_fill(uint8_t*buf, uintptr_t size){
+  for(uintptr_t i=0;i<size;i++){
+    prng_state ^= prng_state << 13;
+    prng_state ^= prng_state >> 17;
+    prng_state ^= prng_state << 5;
+    buf[i] = (uint8_t)prng_state;
+  }
+}
+
+static void model_write(uintptr_t offset, const uint8_t*src, uintptr_t size){
+  memcpy(model+offset,src,size);
+}
+
+//one write, one transaction of two writes, then a read of the whole data
+static void iteration(unsigned int i){
+  uint8_t buf[LFTL_STATIC_DATA_SIZE/2];
+  const uintptr_t offset = (i * 37) % (LFTL_STATIC_DATA_SIZE - sizeof(buf));
+  prng_fill(buf,sizeof(buf));
+  memcpy(model_previous,model,sizeof(model));
+  model_write(offset,buf,sizeof(buf));
+  lftl_write(&area,DATA+offset,buf,sizeof(buf));
+  uint8_t tracker[LFTL_TRANSACTION_TRACKER_SIZE(&area)];
+  memcpy(model_previous,model,sizeof(model));
+  prng_fill(buf,sizeof(buf));
+  model_write(0,buf,LFTL_STATIC_WRITE_SIZE);
+  model_write(LFTL_STATIC_DATA_SIZE - sizeof(buf) + 1,buf+1,sizeof(buf) - 1);
+  lftl_transaction_start(&area,tracker);
+  lftl_transaction_write(&area,DATA,buf,LFTL_STATIC_WRITE_SIZE);
+  lftl_transaction_write_any(&area,DATA + LFTL_STATIC_DATA_SIZE - sizeof(buf) + 1,buf+1,sizeof(buf) - 1);
+  lftl_transaction_commit(&area);
+  uint8_t data[LFTL_STATIC_DATA_SIZE];
+  lftl_read(&area,data,DATA,sizeof(data));
+  if(memcmp(data,model,sizeof(data))) throw_exception(ERROR_VERIFICATION_FAIL);
+}
+
+static void sequence(){
+  for(unsigned int i=0;i<N_ITERATIONS;i++) iteration(i);
+}
+
+static void format(){
+  tearing_sim_init();
+  lftl_format(&area);
+  lftl_read(&area,model,DATA,sizeof(model));
+  memcpy(model_previous,model,sizeof(model));
+  prng_state = 0x53544154;
+}
+
+//after a simulated tearing, the data is the one before or after the interrupted operation
+static bool check_after_reset(){
+  tearing_sim_init();
+  area.data = LFTL_INVALID_POINTER;
+  area.transaction_tracker = LFTL_INVALID_POINTER;
+  uint8_t data[LFTL_STATIC_DATA_SIZE];
+  lftl_read(&area,data,DATA,sizeof(data));
+  if(memcmp(data,model,sizeof(data)) && memcmp(data,model_previous,sizeof(data))) return false;
+  //the next operation goes after the torn one
+  memcpy(model,data,sizeof(model));
+  iteration(N_ITERATIONS);
+  return true;
+}
+
+//nanoseconds per call of each operation, without tearing
+static void timing(){
+  const unsigned int n = 256;
+  uint32_t t_format = 0;
+  uint32_t t_write = 0;
+  uint32_t t_transaction = 0;
+  uint32_t t_read = 0;
+  uint8_t buf[LFTL_STATIC_DATA_SIZE/2];
+  uint8_t tracker[LFTL_TRANSACTION_TRACKER_SIZE(&area)];
+  for(unsigned int i=0;i<n;i++){
+    prng_fill(buf,sizeof(buf));
+    uint32_t t = nvm_clock();
+    lftl_format(&area);
+    t_format += nvm_clock() - t;
+    t = nvm_clock();
+    lftl_write(&area,DATA,buf,sizeof(buf));
+    t_write += nvm_clock() - t;
+    t = nvm_clock();
+    lftl_transaction_start(&area,tracker);
+    lftl_transaction_write(&area,DATA+sizeof(buf),buf,sizeof(buf));
+    lftl_transaction_commit(&area);
+    t_transaction += nvm_clock() - t;
+    t = nvm_clock();
+    lftl_read(&area,buf,DATA+sizeof(buf),sizeof(buf));
+    t_read += nvm_clock() - t;
+  }
+  #ifdef SINGLE_AREA_STATIC
+  PRINTLN("LFTL_STATIC_CONFIG build, nanoseconds per call:");
+  #else
+  PRINTLN("generic build, nanoseconds per call:");
+  #endif
+  PRINTLN("  lftl_format      %8lu",(unsigned long)(t_format/n));
+  PRINTLN("  lftl_write       %8lu",(unsigned long)(t_write/n));
+  PRINTLN("  transaction      %8lu",(unsigned long)(t_transaction/n));
+  PRINTLN("  lftl_read        %8lu",(unsigned long)(t_read/n));
+}
+
+int main(int argc, const char*argv[]){
+  init_nvm_alignement();
+  volatile uint32_t err_code;
+  if(0 != (err_code = setjmp(exception_ctx))){
+    PRINTLN("ERROR: test failed with error code 0x%08lx",(unsigned long)err_code);
+    return 1;
+  }
+  lftl_init_lib();
+  lftl_register_area(&area);
+  format();
+  sequence();
+  const uint32_t target_max = tearing_sim_get_max_target();
+  PRINTF("%u targets for tearing simulation\n",(unsigned int)target_max);
+  for(volatile uint32_t i=0;i<=target_max;i++){
+    format();
+    tearing_sim_set_target(i);
+    if(0 == (err_code = setjmp(exception_ctx))){
+      sequence();
+    } else if((LFTL_ERROR_LOW_LEVEL_WRITE | SIMULATED_TEARING) != err_code && (LFTL_ERROR_LOW_LEVEL_ERASE | SIMULATED_TEARING) != err_code){
+      PRINTLN("ERROR: target %u failed with error code 0x%08lx",(unsigned int)i,(unsigned long)err_code);
+      return 1;
+    }
+    if(0 == (err_code = setjmp(exception_ctx))){
+      if(!check_after_reset()) err_code = ERROR_VERIFICATION_FAIL;
+    }
+    if(err_code){
+      PRINTLN("ERROR: data corrupted after tearing target %u, error code 0x%08lx",(unsigned int)i,(unsigned long)err_code);
+      return 1;
+    }
+  }
+  if(0 != (err_code = setjmp(exception_ctx))){
+    PRINTLN("ERROR: timing failed with error code 0x%08lx",(unsigned long)err_code);
+    return 1;
+  }
+  timing();
+  PRINTLN("PASS");
+  return 0;
+}
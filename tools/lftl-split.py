@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Propose a split of LFTL areas into hot and cold areas from a write profile.
+
+The profile is the output of a firmware built with LFTL_PROFILE, it contains lines:
+
+    LFTL_PROFILE,<area>,,<data size>,<updates>
+    LFTL_PROFILE,<area>,<member>,<size>,<writes>
+
+where <area> and <member> are the names used in LFTL_AREA(<area>, ...) in the layout header,
+<updates> is the number of switches of the current slot of the area and <writes> the number
+of writes of the member (see lftl_profile_writes). Other lines are ignored, so the console
+output of the firmware can be used directly.
+
+Each update of an area programs its whole slot, so members written much more often than
+the others are moved to a hot area with a small slot. The wear leveling factor of each new
+area keeps its erase count per page at or below the one of the original area.
+
+Usage: lftl-split.py <layout header> <profile> [--write-size N] [--emit]
+"""
+
+import argparse
+import math
+import re
+import sys
+
+META_N_ITEMS = 3  # LFTL_META_N_ITEMS
+
+
+def parse_layout(text):
+    """Return {area: (members, factor)} where members is a list of (name, declaration)."""
+    areas = {}
+    for m in re.finditer(r'LFTL_AREA\(\s*(\w+)\s*,', text):
+        # find the matching parenthesis
+        depth = 1
+        i = m.end()
+        while depth:
+            if text[i] == '(':
+                depth += 1
+            elif text[i] == ')':
+                depth -= 1
+            i += 1
+        body = text[m.end():i - 1]
+        content, factor = body.rsplit(',', 1)
+        factor = re.sub(r'LFTL_WEAR_LEVELING_FACTOR\((.*)\)', r'\1', factor.strip())
+        members = []
+        for decl in content.split(';'):
+            decl = decl.strip()
+            if not decl:
+                continue
+            name = re.search(r'(\w+)\s*(\[[^;]*\])?\s*$', decl).group(1)
+            members.append((name, decl + ';'))
+        areas[m.group(1)] = (members, int(factor))
+    return areas
+
+
+def parse_profile(lines):
+    """Return {area: (data_size, updates, {member: (size, writes)})}."""
+    profile = {}
+    for line in lines:
+        fields = line.strip().split(',')
+        if len(fields) != 5 or fields[0] != 'LFTL_PROFILE':
+            continue
+        _, area, member, size, count = fields
+        data_size, updates, members = profile.get(area, (0, 0, {}))
+        if member:
+            members[member] = (int(size), int(count))
+        else:
+            data_size, updates = int(size), int(count)
+        profile[area] = (data_size, updates, members)
+    return profile
+
+
+class Geometry:
+    def __init__(self, write_size):
+        self.write_size = write_size
+
+    def round_wu(self, size):
+        return math.ceil(size / self.write_size) * self.write_size
+
+    def programmed(self, data_size):
+        """Bytes programmed by an update: data and meta data of a slot."""
+        return self.round_wu(data_size) + META_N_ITEMS * max(4, self.write_size)
+
+
+def split_area(data_size, members, updates, geometry):
+    """Return (cost, hot members, hot updates, cold updates) of the best split, hot is empty if none is better."""
+    best = (updates * geometry.programmed(data_size), [], updates, updates)
+    ranked = sorted(members, key=lambda name: members[name][1], reverse=True)
+    for k in range(1, len(ranked)):
+        hot, cold = ranked[:k], ranked[k:]
+        # an update writes at least one member, it may write members of both areas
+        hot_updates = min(updates, sum(members[name][1] for name in hot))
+        cold_updates = min(updates, sum(members[name][1] for name in cold))
+        hot_size = sum(members[name][0] for name in hot)
+        cost = (hot_updates * geometry.programmed(hot_size) +
+                cold_updates * geometry.programmed(data_size - hot_size))
+        if cost < best[0]:
+            best = (cost, hot, hot_updates, cold_updates)
+    return best
+
+
+def factor_for(factor, updates, area_updates):
+    """Wear leveling factor keeping the erase count per page at or below the one of the original area."""
+    if 0 == area_updates:
+        return factor
+    return max(2, math.ceil(factor * updates / area_updates))
+
+
+def emit_area(name, decls, factor):
+    lines = ['  LFTL_AREA(%s,' % name]
+    lines += ['    %s' % decl for decl in decls]
+    lines.append('    ,%d)' % factor)
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('layout', help='header declaring the LFTL areas with LFTL_AREA')
+    parser.add_argument('profile', help='firmware output with LFTL_PROFILE lines, - for stdin')
+    parser.add_argument('--write-size', type=int, default=2, help='write unit size in bytes (default: 2)')
+    parser.add_argument('--emit', action='store_true', help='print the LFTL_AREA declarations of the proposed layout')
+    args = parser.parse_args()
+
+    with open(args.layout) as f:
+        areas = parse_layout(f.read())
+    if args.profile == '-':
+        profile = parse_profile(sys.stdin)
+    else:
+        with open(args.profile) as f:
+            profile = parse_profile(f)
+    geometry = Geometry(args.write_size)
+
+    total_before = 0
+    total_after = 0
+    declarations = []
+    for area, (data_size, updates, members) in profile.items():
+        if area not in areas:
+            sys.exit('area %s is not declared in %s' % (area, args.layout))
+        layout_members, factor = areas[area]
+        decls = dict(layout_members)
+        before = updates * geometry.programmed(data_size)
+        cost, hot, hot_updates, cold_updates = split_area(data_size, members, updates, geometry)
+        total_before += before
+        total_after += cost
+        print('%s: %d updates, %d bytes programmed' % (area, updates, before))
+        if not hot:
+            print('  keep as is')
+            declarations.append(emit_area(area, [decl for _, decl in layout_members], factor))
+            continue
+        cold = [name for name, _ in layout_members if name not in hot]
+        hot_factor = factor_for(factor, hot_updates, updates)
+        cold_factor = factor_for(factor, cold_updates, updates)
+        print('  hot:  %s, about %d updates, wear leveling factor %d' % (' '.join(hot), hot_updates, hot_factor))
+        print('  cold: %s, about %d updates, wear leveling factor %d' % (' '.join(cold), cold_updates, cold_factor))
+        print('  about %d bytes programmed (%.1f%%)' % (cost, 100.0 * cost / before if before else 0))
+        declarations.append(emit_area(area + '_hot', [decls[name] for name in hot if name in decls], hot_factor))
+        declarations.append(emit_area(area + '_cold', [decls[name] for name in cold], cold_factor))
+    if total_before:
+        print('total: %d -> about %d bytes programmed (%.1f%%)' % (total_before, total_after, 100.0 * total_after / total_before))
+    if args.emit:
+        print()
+        print('\n\n'.join(declarations))
+
+
+if __name__ == '__main__':
+    main()